@@ -0,0 +1,200 @@
+// Front-end microbenchmark: generates synthetic Ter sources of a given shape
+// and size, then times Scanner, Parser and Resolver on them and counts the
+// bytes each stage allocates. `--emit <shape>` prints a generated source.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/tokenizer/Scanner.hpp"
+#include "../src/parser/Parser.hpp"
+#include "../src/interpreter/Interpreter.hpp"
+#include "../src/interpreter/Resolver.hpp"
+#include "../src/utils/Debug.hpp"
+#include "../src/utils/Stats.hpp"
+
+namespace {
+  size_t allocatedBytes = 0;
+}
+
+void* operator new(std::size_t size){
+  allocatedBytes += size;
+  if(void* p = std::malloc(size == 0 ? 1 : size)) return p;
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+  using clock = std::chrono::steady_clock;
+
+  // Many small functions with a typical mix of statements
+  std::string functions(int size){
+    std::ostringstream out;
+    for(int i = 0; i < size; ++i){
+      out << "set fn" << i << "(a, b){\n"
+        << "  auto total = a * " << i << " + b\n"
+        << "  for(auto k = 0; k < b; ++k){\n"
+        << "    if(k % 2 == 0){ total = total + k } else { total = total - 1 }\n"
+        << "  }\n"
+        << "  return total\n"
+        << "}\n";
+    }
+    out << "output(fn0(1, 2))\n";
+    return out.str();
+  }
+
+  // Blocks nested 24 deep: stresses the recursive descent and scope stack
+  std::string nested(int size){
+    constexpr int depth = 24;
+    std::ostringstream out;
+    for(int i = 0; i < size / depth + 1; ++i){
+      out << "set nest" << i << "(x){\n";
+      for(int d = 0; d < depth; ++d){
+        out << std::string(static_cast<size_t>(d + 1) * 2, ' ')
+          << "if(x > " << d << "){ auto v" << d << " = x - " << d << "\n";
+      }
+      for(int d = depth - 1; d >= 0; --d){
+        out << std::string(static_cast<size_t>(d + 1) * 2, ' ') << "}\n";
+      }
+      out << "  return x\n}\n";
+    }
+    return out.str();
+  }
+
+  // Long string literals
+  std::string strings(int size){
+    std::ostringstream out;
+    for(int i = 0; i < size; ++i){
+      out << "auto s" << i << " = \"" << std::string(200, static_cast<char>('a' + i % 26))
+        << i << "\" + \"" << std::string(56, 'z') << "\"\n";
+    }
+    return out.str();
+  }
+
+  // Array literals at the parser's limit of 255 elements
+  std::string arrays(int size){
+    std::ostringstream out;
+    for(int i = 0; i < size / 25 + 1; ++i){
+      out << "auto a" << i << " = {";
+      for(int k = 0; k < 255; ++k){
+        out << (k == 0 ? "" : ", ") << (k * 7 + i) % 1000;
+      }
+      out << "}\n";
+    }
+    return out.str();
+  }
+
+  struct Shape {
+    const char* name;
+    std::string (*generate)(int);
+  };
+
+  const Shape shapes[] = {
+    {"functions", functions},
+    {"nested", nested},
+    {"strings", strings},
+    {"arrays", arrays},
+  };
+
+  struct Stage {
+    double bestMs = 1e300;
+    size_t bytes = 0;
+  };
+
+  void report(const char* name, const Stage& stage, const char* unit, size_t count){
+    double perSec = static_cast<double>(count) / (stage.bestMs / 1e3);
+    std::cout << "  " << std::left << std::setw(8) << name << std::right
+      << std::setw(10) << stage.bestMs << " ms"
+      << std::setw(12) << perSec / 1e6 << " M" << unit << "/s"
+      << std::setw(12) << static_cast<double>(stage.bytes) / 1024.0 << " KiB allocated\n";
+  }
+
+  void run(const Shape& shape, int size, int reps){
+    const std::string source = shape.generate(size);
+    Stage scan, parse, resolve;
+    size_t tokenCount = 0, nodeCount = 0;
+
+    for(int rep = 0; rep < reps; ++rep){
+      size_t bytes = allocatedBytes;
+      auto start = clock::now();
+      Scanner scanner(source);
+      std::vector<Token> tokens = scanner.scanTokens();
+      auto end = clock::now();
+      scan.bestMs = std::min(scan.bestMs, std::chrono::duration<double, std::milli>(end - start).count());
+      // The first repetition pays for interning literals, like a fresh process
+      if(rep == 0) scan.bytes = allocatedBytes - bytes;
+      tokenCount = tokens.size();
+
+      bytes = allocatedBytes;
+      uint64_t nodes = Stats::nodes;
+      start = clock::now();
+      Parser parser(tokens, shape.name);
+      std::vector<std::shared_ptr<Statement::Stmt>> statements = parser.parse();
+      end = clock::now();
+      parse.bestMs = std::min(parse.bestMs, std::chrono::duration<double, std::milli>(end - start).count());
+      if(rep == 0) parse.bytes = allocatedBytes - bytes;
+      nodeCount = Stats::nodes - nodes;
+
+      Interpreter interpreter;
+      bytes = allocatedBytes;
+      start = clock::now();
+      Resolver resolver{interpreter};
+      resolver.resolve(statements);
+      end = clock::now();
+      resolve.bestMs = std::min(resolve.bestMs, std::chrono::duration<double, std::milli>(end - start).count());
+      if(rep == 0) resolve.bytes = allocatedBytes - bytes;
+    }
+
+    if(Debug::get_instance().hadError){
+      std::cerr << "Generated '" << shape.name << "' source does not compile.\n";
+      std::exit(EXIT_FAILURE);
+    }
+
+    std::cout << shape.name << ": " << source.size() << " bytes, "
+      << tokenCount << " tokens, " << nodeCount << " AST nodes\n"
+      << std::fixed << std::setprecision(3);
+    report("scan", scan, "tokens", tokenCount);
+    report("parse", parse, "nodes", nodeCount);
+    report("resolve", resolve, "nodes", nodeCount);
+  }
+}
+
+int main(int argc, char** argv){
+  int size = 2000;
+  int reps = 5;
+  std::string only, emit;
+  for(int i = 1; i + 1 < argc; i += 2){
+    std::string option = argv[i];
+    if(option == "--size") size = std::max(1, std::atoi(argv[i + 1]));
+    else if(option == "--reps") reps = std::max(1, std::atoi(argv[i + 1]));
+    else if(option == "--shape") only = argv[i + 1];
+    else if(option == "--emit") emit = argv[i + 1];
+    else{
+      std::cerr << "Usage: " << argv[0] << " [--size N] [--reps N] [--shape name] [--emit name]\n"
+        "Shapes: functions, nested, strings, arrays\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  for(const Shape& shape : shapes){
+    if(!emit.empty()){
+      if(emit == shape.name){
+        std::cout << shape.generate(size);
+        return EXIT_SUCCESS;
+      }
+      continue;
+    }
+    if(only.empty() || only == shape.name){
+      run(shape, size, reps);
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,192 @@
+// Runs every bench/*.ter program several times with the ter binary, reports
+// median/stddev wall time and peak RSS as JSON and compares the medians with
+// a stored baseline. Used by the `ter-bench` and `ter-bench-baseline` targets.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+struct Result {
+  std::string name;
+  int runs = 0;
+  double medianMs = 0;
+  double stddevMs = 0;
+  long peakRssKb = 0;
+  bool failed = false;
+};
+
+// Runs one program with its directory as cwd; returns false when it fails
+bool runOnce(const std::string& ter, const fs::path& script, double& ms, long& rssKb){
+  auto start = std::chrono::steady_clock::now();
+  pid_t pid = fork();
+  if(pid < 0) return false;
+  if(pid == 0){
+    if(chdir(script.parent_path().c_str()) != 0) _exit(127);
+    int null = open("/dev/null", O_WRONLY);
+    if(null >= 0) dup2(null, STDOUT_FILENO);
+    std::string name = script.filename().string();
+    execl(ter.c_str(), ter.c_str(), name.c_str(), static_cast<char*>(nullptr));
+    _exit(127);
+  }
+
+  int status = 0;
+  struct rusage usage{};
+  if(wait4(pid, &status, 0, &usage) < 0) return false;
+  ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  rssKb = usage.ru_maxrss;
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+Result measure(const std::string& ter, const fs::path& script, int runs){
+  Result result;
+  result.name = script.stem().string();
+  result.runs = runs;
+
+  std::vector<double> times;
+  for(int i = 0; i < runs; ++i){
+    double ms = 0;
+    long rss = 0;
+    if(!runOnce(ter, script, ms, rss)){
+      result.failed = true;
+      return result;
+    }
+    times.push_back(ms);
+    result.peakRssKb = std::max(result.peakRssKb, rss);
+  }
+
+  std::sort(times.begin(), times.end());
+  size_t n = times.size();
+  result.medianMs = n % 2 == 1 ? times[n / 2] : (times[n / 2 - 1] + times[n / 2]) / 2;
+  double mean = 0;
+  for(double t : times) mean += t;
+  mean /= static_cast<double>(n);
+  double variance = 0;
+  for(double t : times) variance += (t - mean) * (t - mean);
+  result.stddevMs = n > 1 ? std::sqrt(variance / static_cast<double>(n - 1)) : 0.0;
+  return result;
+}
+
+void writeJson(std::ostream& out, const std::vector<Result>& results){
+  out << "{\"benchmarks\":[\n";
+  for(size_t i = 0; i < results.size(); ++i){
+    const Result& r = results[i];
+    out << std::fixed << std::setprecision(3)
+      << "  {\"name\":\"" << r.name << "\",\"runs\":" << r.runs
+      << ",\"median_ms\":" << r.medianMs << ",\"stddev_ms\":" << r.stddevMs
+      << ",\"peak_rss_kb\":" << r.peakRssKb
+      << ",\"failed\":" << (r.failed ? "true" : "false") << '}'
+      << (i + 1 < results.size() ? ",\n" : "\n");
+  }
+  out << "]}\n";
+}
+
+// Reads the medians back from a file written by writeJson
+std::map<std::string, double> readBaseline(const fs::path& path){
+  std::map<std::string, double> medians;
+  std::ifstream in(path);
+  std::string line;
+  while(std::getline(in, line)){
+    auto name = line.find("\"name\":\"");
+    auto median = line.find("\"median_ms\":");
+    if(name == std::string::npos || median == std::string::npos) continue;
+    name += 8;
+    medians[line.substr(name, line.find('"', name) - name)] = std::atof(line.c_str() + median + 12);
+  }
+  return medians;
+}
+
+int main(int argc, char** argv){
+  if(argc < 3){
+    std::cerr << "Usage: " << argv[0] << " <ter> <bench dir> [--runs N] [--out results.json]"
+      " [--baseline baseline.json] [--threshold percent]\n";
+    return EXIT_FAILURE;
+  }
+
+  std::string ter = fs::absolute(argv[1]).string();
+  fs::path dir = argv[2];
+  int runs = 5;
+  double threshold = 10;
+  std::string out, baseline;
+  for(int i = 3; i + 1 < argc; i += 2){
+    std::string option = argv[i];
+    if(option == "--runs") runs = std::max(1, std::atoi(argv[i + 1]));
+    else if(option == "--out") out = argv[i + 1];
+    else if(option == "--baseline") baseline = argv[i + 1];
+    else if(option == "--threshold") threshold = std::atof(argv[i + 1]);
+  }
+
+  std::vector<fs::path> scripts;
+  for(const auto& entry : fs::directory_iterator(dir)){
+    if(entry.path().extension() == ".ter") scripts.push_back(entry.path());
+  }
+  std::sort(scripts.begin(), scripts.end());
+
+  std::map<std::string, double> previous;
+  if(!baseline.empty() && fs::exists(baseline)){
+    previous = readBaseline(baseline);
+  }
+
+  std::vector<Result> results;
+  bool regressed = false;
+  std::cout << std::left << std::setw(16) << "benchmark" << std::right
+    << std::setw(12) << "median ms" << std::setw(12) << "stddev ms"
+    << std::setw(14) << "peak RSS KB" << std::setw(12) << "baseline" << '\n';
+
+  for(const fs::path& script : scripts){
+    Result r = measure(ter, script, runs);
+    results.push_back(r);
+
+    std::cout << std::left << std::setw(16) << r.name << std::right << std::fixed << std::setprecision(1);
+    if(r.failed){
+      std::cout << "  FAILED (non-zero exit)\n";
+      regressed = true;
+      continue;
+    }
+    std::cout << std::setw(12) << r.medianMs << std::setw(12) << r.stddevMs
+      << std::setw(14) << r.peakRssKb;
+
+    auto it = previous.find(r.name);
+    if(it != previous.end() && it->second > 0){
+      double change = (r.medianMs - it->second) / it->second * 100.0;
+      std::cout << std::setw(11) << std::showpos << change << std::noshowpos << '%';
+      if(change > threshold){
+        std::cout << "  REGRESSION";
+        regressed = true;
+      }
+    }
+    std::cout << '\n';
+  }
+
+  if(!out.empty()){
+    std::ofstream file(out);
+    if(!file){
+      std::cerr << "Cannot write results to '" << out << "'.\n";
+      return EXIT_FAILURE;
+    }
+    writeJson(file, results);
+    std::cout << "Results written to " << out << '\n';
+  }
+
+  if(regressed){
+    std::cout << "Slower than the baseline by more than " << threshold << "% or failed.\n";
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,88 @@
+// Example native extension: vector kernels over Ter's packed numeric arrays.
+// Build with the `vecmath` target, then in a script:
+//   import_native("./libvecmath.so")
+//   output(vec_dot({1, 2, 3}, {4, 5, 6}))
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "terlang.h"
+
+namespace {
+  // An argument read as numbers: in place when possible, otherwise copied
+  // element by element (arrays a parallel worker shares are not packed)
+  struct Numbers {
+    const double* data = nullptr;
+    std::size_t length = 0;
+    std::vector<double> copy;
+  };
+
+  // Fills `out`, or raises a Ter runtime error
+  bool numbers(ter_isolate* isolate, ter_value* value, Numbers& out, const char* message){
+    out.data = ter_array_view(value, &out.length);
+    if(out.data != nullptr) return true;
+    if(ter_typeof(value) == TER_ARRAY){
+      out.length = ter_array_length(value);
+      out.copy.reserve(out.length);
+      for(std::size_t i = 0; i < out.length; ++i){
+        ter_value* element = ter_array_get(value, i);
+        bool number = ter_typeof(element) == TER_NUMBER;
+        if(number) out.copy.push_back(ter_to_number(element));
+        ter_value_free(element);
+        if(!number) break;
+      }
+      if(out.copy.size() == out.length){
+        out.data = out.copy.data();
+        return true;
+      }
+    }
+    ter_error(isolate, message);
+    return false;
+  }
+
+  ter_value* dot(ter_isolate* isolate, ter_value* const* args, std::size_t, void*){
+    Numbers a, b;
+    if(!numbers(isolate, args[0], a, "vec_dot() expects arrays of numbers.") ||
+        !numbers(isolate, args[1], b, "vec_dot() expects arrays of numbers.")) return nullptr;
+    if(a.length != b.length){
+      ter_error(isolate, "vec_dot() expects arrays of the same length.");
+      return nullptr;
+    }
+    double total = 0;
+    for(std::size_t i = 0; i < a.length; ++i){
+      total += a.data[i] * b.data[i];
+    }
+    return ter_number(total);
+  }
+
+  ter_value* scale(ter_isolate* isolate, ter_value* const* args, std::size_t, void*){
+    Numbers a;
+    if(!numbers(isolate, args[0], a, "vec_scale() expects an array of numbers.")) return nullptr;
+    double k = ter_to_number(args[1]);
+    double* out = nullptr;
+    ter_value* result = ter_array_new(a.length, &out);
+    for(std::size_t i = 0; i < a.length; ++i){
+      out[i] = a.data[i] * k;
+    }
+    return result;
+  }
+
+  ter_value* norm(ter_isolate* isolate, ter_value* const* args, std::size_t, void*){
+    Numbers a;
+    if(!numbers(isolate, args[0], a, "vec_norm() expects an array of numbers.")) return nullptr;
+    double total = 0;
+    for(std::size_t i = 0; i < a.length; ++i){
+      total += a.data[i] * a.data[i];
+    }
+    return ter_number(std::sqrt(total));
+  }
+
+  int init(ter_isolate* isolate){
+    return ter_register(isolate, "vec_dot", 2, dot, nullptr) ||
+      ter_register(isolate, "vec_scale", 2, scale, nullptr) ||
+      ter_register(isolate, "vec_norm", 1, norm, nullptr);
+  }
+}
+
+TER_EXTENSION("vecmath", init);
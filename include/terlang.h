@@ -0,0 +1,134 @@
+#ifndef TERLANG_H
+#define TERLANG_H
+
+/* C API of libterlang, for embedding Ter in C and C++ programs.
+
+   Every ter_isolate is an independent interpreter with its own globals:
+   isolates may run concurrently on different threads, but one isolate must
+   only be used by one thread at a time. Globals defined by ter_eval() stay
+   alive, so a program is evaluated once and its functions are then called
+   with ter_call() as often as needed.
+
+   Values are handles owned by the caller and released with
+   ter_value_free(), except the arguments passed to a native function, which
+   are borrowed for the duration of the call. Strings and numeric arrays are
+   shared with the interpreter, not copied: ter_string_data() and
+   ter_array_view() point into the Ter value, and ter_string_new() and
+   ter_array_new() return a buffer to be filled in place. */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TER_API_VERSION 1
+
+typedef struct ter_isolate ter_isolate;
+typedef struct ter_value ter_value;
+
+typedef enum {
+  TER_NULL,
+  TER_BOOL,
+  TER_NUMBER,
+  TER_STRING,
+  TER_ARRAY,
+  TER_FUNCTION,
+  TER_CLASS,
+  TER_INSTANCE
+} ter_type;
+
+/* Flags of ter_isolate_new() */
+#define TER_CAPTURE_OUTPUT 1
+
+/* Called from Ter with borrowed arguments; returns a new value (or NULL for
+   null), or reports a runtime error with ter_error() and returns NULL. */
+typedef ter_value* (*ter_native)(ter_isolate* isolate, ter_value* const* args, size_t count, void* data);
+
+/* Isolates. args() in scripts returns argv[2..]. No C++ exception ever
+   leaves these functions: failures are reported through return values and
+   ter_last_error(). */
+ter_isolate* ter_isolate_new(int argc, const char* const* argv, int flags);
+void ter_isolate_free(ter_isolate* isolate);
+
+/* Runs a program; returns 0, or the exit code `ter` would have returned */
+int ter_eval(ter_isolate* isolate, const char* source, size_t length, const char* name);
+
+/* Calls a global function or class; returns NULL and sets ter_last_error() on failure */
+ter_value* ter_call(ter_isolate* isolate, const char* function, ter_value* const* args, size_t count);
+
+/* Defines a global function; arity -1 accepts any number of arguments.
+   Fails inside parallel workers and spawned tasks, which share globals. */
+int ter_register(ter_isolate* isolate, const char* name, int arity, ter_native function, void* data);
+
+/* Value of a global, or NULL when it is not defined */
+ter_value* ter_get_global(ter_isolate* isolate, const char* name);
+
+/* Errors reported by the last ter_eval()/ter_call(), "" when there were none */
+const char* ter_last_error(ter_isolate* isolate);
+/* From a native function: fails the call with a runtime error */
+void ter_error(ter_isolate* isolate, const char* message);
+
+/* Output printed so far by an isolate created with TER_CAPTURE_OUTPUT */
+const char* ter_output(ter_isolate* isolate, size_t* length);
+void ter_output_clear(ter_isolate* isolate);
+
+/* Native extensions. A shared library loaded with import_native("path") in
+   a script, or with ter_import_native(), exports a ter_extension named
+   ter_extension_info, usually with TER_EXTENSION(). Its init function
+   registers globals with ter_register() and returns 0; the library resolves
+   the ter_* functions from the host that loads it. Extensions built
+   against an older TER_API_VERSION keep loading; newer ones are refused. */
+typedef struct {
+  int api_version;
+  const char* name;
+  int (*init)(ter_isolate* isolate);
+} ter_extension;
+
+#ifdef __cplusplus
+#define TER_EXTENSION_EXPORT extern "C" __attribute__((visibility("default")))
+#else
+#define TER_EXTENSION_EXPORT __attribute__((visibility("default")))
+#endif
+
+#define TER_EXTENSION(name, init) \
+  TER_EXTENSION_EXPORT const ter_extension ter_extension_info = { TER_API_VERSION, name, init }
+
+/* Loads an extension once per isolate; non-zero and ter_last_error() on
+   failure, as in parallel workers and spawned tasks */
+int ter_import_native(ter_isolate* isolate, const char* path);
+
+/* Values. The sized constructors return NULL when out of memory. */
+ter_value* ter_null(void);
+ter_value* ter_bool(int value);
+ter_value* ter_number(double value);
+ter_value* ter_string(const char* text, size_t length);
+/* A string of `length` bytes to be written through *data before first use */
+ter_value* ter_string_new(size_t length, char** data);
+ter_value* ter_array(const double* numbers, size_t length);
+/* A numeric array of `length` elements to be written through *data */
+ter_value* ter_array_new(size_t length, double** data);
+ter_value* ter_value_copy(const ter_value* value);
+void ter_value_free(ter_value* value);
+
+ter_type ter_typeof(const ter_value* value);
+double ter_to_number(const ter_value* value);
+int ter_to_bool(const ter_value* value);
+/* Characters of a string, valid while the value is alive; NULL otherwise */
+const char* ter_string_data(const ter_value* value, size_t* length);
+size_t ter_array_length(const ter_value* value);
+/* Element of an array as a new value */
+ter_value* ter_array_get(const ter_value* value, size_t index);
+/* Elements of an array holding only numbers, valid while the value is
+   alive and the array is not modified; NULL for other arrays, and for
+   unpacked arrays a parallel worker shares with other threads (read them
+   with ter_array_get() instead) */
+const double* ter_array_view(const ter_value* value, size_t* length);
+/* Same, to be modified in place; NULL for frozen and shared arrays too */
+double* ter_array_numbers(ter_value* value, size_t* length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
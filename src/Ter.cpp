@@ -4,29 +4,29 @@
 #include <fstream>
 
 #include "Ter.hpp"
-#include "utils/Debug.hpp"
+#include "utils/Tracer.hpp"
+#include "utils/Stats.hpp"
+#include "utils/PerfCounters.hpp"
 #include "tokenizer/Scanner.hpp"
 #include "parser/Parser.hpp"
-#include "interpreter/Interpreter.hpp"
+#include "interpreter/Isolate.hpp"
 #include "interpreter/Resolver.hpp"
 
 namespace fs = std::filesystem;
 
-Interpreter interpreter{};
-
-void Ter::run_file(const std::string& path){
-
-  Debug::filename = path;
+int Ter::run_file(const std::string& path){
+  Isolate& isolate = Isolate::current();
+  isolate.debug.filename = path;
 
   if(!fs::exists(path)){
-    std::cerr << "File not found.\n";
-    std::exit(66);
+    isolate.errors << "File not found.\n";
+    return 66;
   }
 
   std::ifstream file(path, std::ios::binary | std::ios::ate);
   if(!file){
-    std::cerr << "Permission error opening file.\n";
-    std::exit(66);
+    isolate.errors << "Permission error opening file.\n";
+    return 66;
   }
 
   std::streamsize size = file.tellg();
@@ -34,54 +34,165 @@ void Ter::run_file(const std::string& path){
   std::vector<char> buffer(static_cast<size_t>(size));
 
   if(!file.read(buffer.data(), size)){
-    std::cerr << "Error reading file.\n";
-    std::exit(77);
+    isolate.errors << "Error reading file.\n";
+    return 77;
   }
 
   std::string content(buffer.begin(), buffer.end());
-  run(content);
-  if(Debug::hadError){ std::exit(65); }
-  if(Debug::hadRuntimeError){ std::exit(70); }
+  return run_program(content, path);
 }
 
-void Ter::repl(){
+int Ter::repl(){
+  Isolate& isolate = Isolate::current();
   std::string line;
   std::cout << "ter> ";
   for(;;){
     if(!std::getline(std::cin, line) || line == "exit"){
       break;
     }
-    run(line);
-    if(Debug::hadError){ std::exit(65); }
-    if(Debug::hadRuntimeError){ std::exit(70); }
+    try{
+      run(line, "<repl>");
+    }catch(const Isolate::Exit& exit){
+      return exit.code;
+    }
+    if(int status = isolate.status()){ return status; }
+    isolate.output.flush();
     std::cout << "ter> ";
   }
+  return 0;
 }
 
-void Ter::run_script(const std::string& script){
-  run(script);
-  if(Debug::hadError){ std::exit(65); }
-  if(Debug::hadRuntimeError){ std::exit(70); }
+int Ter::run_script(const std::string& script){
+  return run_program(script, "<script>");
 }
 
-void Ter::run(const std::string& source){
-  Scanner scanner(source);
-  std::vector<Token> tokens = scanner.scanTokens();
-  if(Debug::hadError){ return; }
-  Debug::filename = source;
+// Runs a whole program and reports diagnostics, even when it stops early
+int Ter::run_program(const std::string& source, const std::string& path){
+  int status = 0;
+  try{
+    run(source, path);
+    status = Isolate::current().status();
+  }catch(const Isolate::Exit& exit){
+    Stats::get().runStart = {};
+    status = exit.code;
+  }
+  finish();
+  return status;
+}
+
+void Ter::run(const std::string& source, const std::string& path){
+  Isolate& isolate = Isolate::current();
+  Interpreter& interpreter = isolate.interpreter;
+  if(!options.trace.empty() && !Tracer::get_instance().enabled()){
+    Tracer::get_instance().start(options.traceThresholdUs);
+    interpreter.tracer = &Tracer::get_instance();
+  }
+  if(options.perf){
+    PerfCounters::get_instance().open();
+  }
+  // Attached before scanning so interned literals are counted too
+  if(options.heapProfile && interpreter.heapProfiler == nullptr){
+    interpreter.heapProfiler = std::make_unique<HeapProfiler>();
+    HeapProfiler::active = interpreter.heapProfiler.get();
+  }
+
+  std::vector<Token> tokens;
+  {
+    Tracer::Span span{"phase", "scan " + path};
+    Stats::Phase phase{Stats::get().scanNs, Stats::get().scanPerf};
+    Scanner scanner(source);
+    tokens = scanner.scanTokens();
+  }
+  Stats::get().tokens += tokens.size();
+  if(isolate.debug.hadError){ return; }
+  isolate.debug.filename = source;
 
   //Parser parser{tokens};
   //std::vector<std::shared_ptr<Statement::Stmt>> statements = parser.parse();
-  auto parser = std::make_unique<Parser>(tokens);
+  auto parser = std::make_unique<Parser>(tokens, path);
 
-  std::vector<std::shared_ptr<Statement::Stmt>> statements = parser->parse();
-  if(Debug::hadError){ return; }
+  std::vector<std::shared_ptr<Statement::Stmt>> statements;
+  {
+    Tracer::Span span{"phase", "parse " + path};
+    Stats::Phase phase{Stats::get().parseNs, Stats::get().parsePerf};
+    statements = parser->parse();
+  }
+  if(isolate.debug.hadError){ return; }
 
-  interpreter.lateInitializator();
-  Resolver resolver{interpreter};
-  resolver.resolve(statements);
-  if(Debug::hadError){ return; }
+  if(options.profile && interpreter.profiler == nullptr){
+    interpreter.profiler = std::make_unique<Profiler>();
+  }
+  if(!options.sampleProfile.empty() && interpreter.sampler == nullptr){
+    interpreter.sampler = std::make_unique<Sampler>();
+    interpreter.sampler->start();
+  }
+  if(options.lineProfile){
+    if(interpreter.lineProfiler == nullptr){
+      interpreter.lineProfiler = std::make_unique<LineProfiler>();
+    }
+    interpreter.lineProfiler->addSource(path, source);
+    interpreter.lineProfiler->add(statements);
+  }
+  {
+    Tracer::Span span{"phase", "resolve " + path};
+    Stats::Phase phase{Stats::get().resolveNs, Stats::get().resolvePerf};
+    Resolver resolver{interpreter};
+    resolver.resolve(statements);
+  }
+  if(isolate.debug.hadError){ return; }
+
+  Tracer::Span span{"phase", "run " + path};
+  {
+    Stats::Phase phase{Stats::get().runNs, Stats::get().runPerf};
+    Stats::get().runStart = Stats::clock::now();
+    interpreter.interpret(statements);
+    Stats::get().runStart = {};
+  }
+}
+
+// Reports collected diagnostics once the script is done
+void Ter::finish(){
+  Isolate& isolate = Isolate::current();
+  Interpreter& interpreter = isolate.interpreter;
+  std::ostream& errors = isolate.errors;
+  isolate.output.flush();
+
+  if(options.stats){
+    Stats::report(errors);
+  }
+
+  if(interpreter.heapProfiler != nullptr){
+    interpreter.heapProfiler->report(errors);
+  }
+
+  if(interpreter.sampler != nullptr){
+    interpreter.sampler->stop();
+    interpreter.sampler->write(options.sampleProfile);
+  }
+
+  if(interpreter.tracer != nullptr){
+    interpreter.tracer->write(options.trace);
+  }
+
+  if(interpreter.lineProfiler != nullptr){
+    interpreter.lineProfiler->report(errors);
+    std::ofstream lcov(options.lineProfileLcov);
+    if(!lcov){
+      errors << "Cannot write coverage to '" << options.lineProfileLcov << "'.\n";
+    }else{
+      interpreter.lineProfiler->writeLcov(lcov);
+    }
+  }
 
-  interpreter.interpret(statements);
-  if(Debug::hadError){ return; }
+  if(interpreter.profiler != nullptr){
+    interpreter.profiler->report(errors);
+    if(!options.profileJson.empty()){
+      std::ofstream json(options.profileJson);
+      if(!json){
+        errors << "Cannot write profile to '" << options.profileJson << "'.\n";
+      }else{
+        interpreter.profiler->writeJson(json);
+      }
+    }
+  }
 }
@@ -1,13 +1,33 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 
+// Diagnostics requested on the command line
+struct TerOptions {
+  bool profile = false;
+  bool stats = false;
+  bool heapProfile = false;
+  bool perf = false;
+  std::string profileJson;
+  std::string sampleProfile;
+  bool lineProfile = false;
+  std::string lineProfileLcov = "lcov.info";
+  std::string trace;
+  int64_t traceThresholdUs = 1000;
+};
+
 class Ter {
   private: 
-    static void run(const std::string&);
+    static void run(const std::string&, const std::string& path);
+    static void finish();
 
   public:
-    static void run_file(const std::string&);
-    static void run_script(const std::string&);
-    static void repl();
+    inline static TerOptions options;
+    // Run in Isolate::current() and return the process exit code
+    static int run_file(const std::string&);
+    static int run_script(const std::string&);
+    static int repl();
+    // Runs source in Isolate::current(), then reports diagnostics
+    static int run_program(const std::string&, const std::string& path);
 };
@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "TestRunner.hpp"
+#include "Ter.hpp"
+#include "interpreter/Isolate.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+  // A test still running after this long fails the run
+  constexpr int timeoutSeconds = 60;
+
+  struct Test {
+    fs::path script;
+    std::string out;
+    std::string err;
+    int exitCode = 0;
+    double ms = 0;
+    bool passed = false;
+    std::string reason;
+  };
+
+  struct Slot {
+    std::atomic<size_t> test{0};
+    std::atomic<std::chrono::steady_clock::rep> since{0};
+  };
+
+  std::string readFile(const fs::path& path){
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    return buffer.str();
+  }
+
+  // Golden files are compared like run.sh does: trailing newlines don't count
+  std::string trimmed(std::string text){
+    while(!text.empty() && (text.back() == '\n' || text.back() == '\r')) text.pop_back();
+    return text;
+  }
+
+  // Runs the script in an isolate of its own, with includes resolved
+  // against its directory and both output streams captured
+  void execute(Test& test){
+    std::vector<std::string> args{"ter", test.script.filename().string()};
+    fs::path argsFile = test.script.string() + ".args";
+    if(fs::exists(argsFile)){
+      std::istringstream words(readFile(argsFile));
+      std::string word;
+      while(words >> word) args.push_back(word);
+    }
+
+    std::ostringstream errors;
+    auto start = std::chrono::steady_clock::now();
+    {
+      Isolate isolate{args, &test.out, errors};
+      isolate.dir = test.script.parent_path();
+      Isolate::Scope scope{isolate};
+      test.exitCode = Ter::run_file(test.script.string());
+    }
+    test.err = errors.str();
+    test.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  double elapsedMs(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  // Prints the tests that are done, the one that timed out if any, and the
+  // totals; 0 when all passed
+  int report(const std::vector<Test>& tests, const std::vector<std::atomic<bool>>& done, double total,
+      unsigned workers, const Test* timedOut = nullptr){
+    size_t passed = 0, failed = 0;
+    std::cout << std::fixed << std::setprecision(1);
+    for(size_t i = 0; i < tests.size(); ++i){
+      if(!done[i].load(std::memory_order_acquire)) continue;
+      const Test& test = tests[i];
+      std::cout << (test.passed ? "PASS  " : "FAIL  ")
+        << std::left << std::setw(32) << test.script.filename().string()
+        << std::right << std::setw(10) << test.ms << " ms\n";
+      if(test.passed){
+        ++passed;
+      }else{
+        ++failed;
+        std::cout << "  " << test.reason << '\n';
+      }
+    }
+    if(timedOut != nullptr){
+      ++failed;
+      std::cout << "FAIL  " << timedOut->script.filename().string()
+        << "\n  timed out after " << timeoutSeconds << "s, the run was stopped\n";
+    }
+
+    std::cout << "----------------\n"
+      << "Total: " << tests.size() << ", passed: " << passed << ", failed: " << failed;
+    if(passed + failed < tests.size()){
+      std::cout << ", unfinished: " << tests.size() - passed - failed;
+    }
+    std::cout << " (" << total << " ms on " << workers << " threads)" << std::endl;
+    return passed == tests.size() ? 0 : 1;
+  }
+
+  void check(Test& test){
+    if(!test.reason.empty()) return;
+
+    fs::path result = test.script.string() + ".result";
+    fs::path error = test.script.string() + ".error";
+    bool expectsError = fs::exists(error);
+    std::string expectedOut = fs::exists(result) ? trimmed(readFile(result)) : "";
+    std::string expectedErr = expectsError ? trimmed(readFile(error)) : "";
+
+    if(test.exitCode != 0 && !expectsError){
+      test.reason = "exit code " + std::to_string(test.exitCode) + "\n  stderr: " + test.err;
+    }else if(trimmed(test.out) != expectedOut){
+      test.reason = "stdout differs\n  expected: '" + expectedOut + "'\n  found:    '" + trimmed(test.out) + "'";
+    }else if(trimmed(test.err) != expectedErr){
+      test.reason = "stderr differs\n  expected: '" + expectedErr + "'\n  found:    '" + trimmed(test.err) + "'";
+    }else{
+      test.passed = true;
+    }
+  }
+}
+
+int TestRunner::run(const std::string& dir){
+  if(!fs::is_directory(dir)){
+    std::cerr << "Test directory '" << dir << "' not found.\n";
+    return 66;
+  }
+
+  std::vector<Test> tests;
+  for(const auto& entry : fs::directory_iterator(dir)){
+    if(entry.path().extension() == ".ter"){
+      tests.push_back({});
+      tests.back().script = fs::absolute(entry.path());
+    }
+  }
+  std::sort(tests.begin(), tests.end(), [](const Test& a, const Test& b){ return a.script < b.script; });
+
+  auto start = std::chrono::steady_clock::now();
+  std::atomic<size_t> next{0};
+  std::atomic<size_t> finished{0};
+  // Set once a test is checked, so the watchdog may report it
+  std::vector<std::atomic<bool>> done(tests.size());
+  unsigned workers = std::max(1u, std::min(std::thread::hardware_concurrency(), static_cast<unsigned>(tests.size())));
+  // Test each worker is running and since when, for the watchdog
+  std::vector<Slot> slots(workers);
+  std::vector<std::thread> pool;
+  for(unsigned i = 0; i < workers; ++i){
+    pool.emplace_back([&, i]{
+      for(size_t t = next++; t < tests.size(); t = next++){
+        slots[i].test = t;
+        slots[i].since = std::chrono::steady_clock::now().time_since_epoch().count();
+        execute(tests[t]);
+        check(tests[t]);
+        done[t].store(true, std::memory_order_release);
+        slots[i].since = 0;
+        ++finished;
+      }
+    });
+  }
+
+  // A thread cannot be killed: a test that hangs ends the whole run, after
+  // reporting what finished so far
+  while(finished < tests.size()){
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    for(const Slot& slot : slots){
+      auto since = slot.since.load();
+      if(since != 0 && now - std::chrono::steady_clock::duration(since) > std::chrono::seconds(timeoutSeconds)){
+        report(tests, done, elapsedMs(start), workers, &tests[slot.test]);
+        std::_Exit(1);
+      }
+    }
+  }
+  for(std::thread& thread : pool) thread.join();
+  return report(tests, done, elapsedMs(start), workers);
+}
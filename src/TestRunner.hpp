@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+/* `ter --test <dir>`: runs every .ter file of a directory in an isolate of
+   its own on a pool of threads and checks it against the golden files next
+   to it. stdout must match `name.ter.result`, stderr must match
+   `name.ter.error`, and a non-zero exit code is only accepted when
+   `name.ter.error` exists; `name.ter.args` holds extra whitespace-separated
+   arguments. exec() output is not captured. */
+class TestRunner {
+  public:
+    // Returns the process exit code: zero when every test passed
+    static int run(const std::string& dir);
+};
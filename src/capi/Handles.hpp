@@ -0,0 +1,31 @@
+#pragma once
+
+#include <memory>
+#include <sstream>
+
+#include "../../include/terlang.h"
+#include "../interpreter/Isolate.hpp"
+
+struct ter_value {
+  std::any value;
+};
+
+/* C handle of an isolate. ter_isolate_new() creates one that owns its
+   isolate and collects its output and errors; extensions loaded by
+   import_native() get a view of an isolate that reports as usual. */
+struct ter_isolate {
+  // Declared before the isolate, which writes to them until destroyed
+  std::string output;
+  std::ostringstream errors;
+  std::string lastError;
+  std::unique_ptr<Isolate> owned;
+  Isolate& isolate;
+
+  ter_isolate(std::vector<std::string> args, bool capture) :
+    owned{std::make_unique<Isolate>(std::move(args), capture ? &output : nullptr, errors)},
+    isolate{*owned} {}
+  explicit ter_isolate(Isolate& running) : isolate{running} {}
+};
+
+// The handle of an isolate, created the first time one is needed
+ter_isolate* handleOf(Isolate& isolate);
@@ -0,0 +1,440 @@
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+#include "Handles.hpp"
+#include "../Ter.hpp"
+#include "../interpreter/ArrayType.hpp"
+#include "../interpreter/StringType.hpp"
+#include "../interpreter/Function.hpp"
+#include "../interpreter/Class.hpp"
+#include "../interpreter/Instance.hpp"
+
+namespace {
+  ter_value* wrap(std::any value){
+    return new ter_value{std::move(value)};
+  }
+
+  // Reports what the isolate printed to its error stream during one call
+  void collectErrors(ter_isolate* isolate){
+    if(isolate->errors.tellp() == 0){
+      isolate->lastError.clear();
+      return;
+    }
+    isolate->lastError = isolate->errors.str();
+    isolate->errors.str("");
+  }
+
+  // Reports an exception no Ter code raised, such as bad_alloc, instead of
+  // letting it unwind into C
+  void reportException(ter_isolate* isolate){
+    isolate->isolate.output.flush();
+    try{
+      throw;
+    }catch(const std::exception& exception){
+      isolate->errors << "Error: " << exception.what() << '\n';
+    }catch(...){
+      isolate->errors << "Error: unknown exception.\n";
+    }
+  }
+
+  // Arrays older than the running worker or task are read by other threads
+  // as well, so they are never converted in place
+  bool shared(const ArrayType& array){
+    uint64_t epoch = Isolate::current().interpreter.sharedEpoch;
+    return epoch != 0 && array.epoch < epoch;
+  }
+
+  // Native call running on this thread, the target of ter_error(). Each
+  // call has its own, so threads calling the same function don't mix errors
+  struct Frame {
+    std::string error;
+  };
+  thread_local Frame* running = nullptr;
+
+  // Makes a frame the running one until the native function returns or throws
+  struct Entered {
+    Frame* caller;
+
+    explicit Entered(Frame& frame) : caller{running} {
+      running = &frame;
+    }
+    ~Entered(){
+      running = caller;
+    }
+    Entered(const Entered&) = delete;
+    void operator=(const Entered&) = delete;
+  };
+
+  /* Global function implemented in C. Errors raised with ter_error() are
+     thrown as runtime errors once the C function returns. */
+  class Native : public Callable {
+    public:
+      Native(ter_isolate* owner, const std::string& label, int arity, ter_native native, void* userData) :
+        isolate{owner}, name{TokenType::IDENTIFIER, label, {}, 0}, nativeArity{arity}, function{native}, data{userData} {}
+
+      int arity() override {
+        return nativeArity;
+      }
+
+      std::any call(Interpreter&, std::vector<std::any> arguments) override {
+        if(nativeArity >= 0 && arguments.size() != static_cast<size_t>(nativeArity)){
+          throw RuntimeError{name, "Expected " + std::to_string(nativeArity) + " arguments to '" +
+            name.lexeme + "' but got " + std::to_string(arguments.size()) + "."};
+        }
+
+        // Borrowed handles: the arguments are moved in, not copied
+        std::vector<ter_value> values;
+        values.reserve(arguments.size());
+        for(std::any& argument : arguments){
+          values.push_back({std::move(argument)});
+        }
+        std::vector<ter_value*> handles;
+        handles.reserve(values.size());
+        for(ter_value& value : values){
+          handles.push_back(&value);
+        }
+
+        Frame frame;
+        ter_value* result;
+        {
+          Entered entered{frame};
+          try{
+            result = function(isolate, handles.data(), handles.size(), data);
+          }catch(const std::exception& exception){
+            // Thrown by an extension written in C++
+            throw RuntimeError{name, std::string("Native function failed: ") + exception.what()};
+          }
+        }
+        if(!frame.error.empty()){
+          delete result;
+          throw RuntimeError{name, frame.error};
+        }
+        if(result == nullptr){
+          return nullptr;
+        }
+        std::any value = std::move(result->value);
+        delete result;
+        return value;
+      }
+
+      std::string toString() override {
+        return "<function native>";
+      }
+
+    private:
+      ter_isolate* isolate;
+      // Runtime errors keep a reference to their token
+      Token name;
+      int nativeArity;
+      ter_native function;
+      void* data;
+  };
+}
+
+ter_isolate* handleOf(Isolate& isolate){
+  if(isolate.handle == nullptr){
+    isolate.handle = std::make_shared<ter_isolate>(isolate);
+  }
+  return isolate.handle.get();
+}
+
+extern "C" {
+
+ter_isolate* ter_isolate_new(int argc, const char* const* argv, int flags){
+  std::vector<std::string> args;
+  for(int i = 0; i < argc; ++i){
+    args.emplace_back(argv[i]);
+  }
+  ter_isolate* isolate;
+  try{
+    isolate = new ter_isolate{std::move(args), (flags & TER_CAPTURE_OUTPUT) != 0};
+  }catch(...){
+    return nullptr;
+  }
+  // Not owning: this handle owns the isolate
+  isolate->isolate.handle = std::shared_ptr<ter_isolate>(isolate, [](ter_isolate*){});
+  return isolate;
+}
+
+void ter_isolate_free(ter_isolate* isolate){
+  if(isolate == nullptr) return;
+  Isolate::Scope scope{isolate->isolate};
+  delete isolate;
+}
+
+int ter_eval(ter_isolate* isolate, const char* source, size_t length, const char* name){
+  Isolate::Scope scope{isolate->isolate};
+  // Each evaluation starts clean; globals of earlier ones are kept
+  isolate->isolate.debug.hadError = false;
+  isolate->isolate.debug.hadRuntimeError = false;
+  int status;
+  try{
+    status = Ter::run_program(std::string(source, length), name != nullptr ? name : "<embedded>");
+  }catch(...){
+    reportException(isolate);
+    status = 70;
+  }
+  collectErrors(isolate);
+  return status;
+}
+
+ter_value* ter_call(ter_isolate* isolate, const char* function, ter_value* const* args, size_t count){
+  Isolate::Scope scope{isolate->isolate};
+  Interpreter& interpreter = isolate->isolate.interpreter;
+  Token name{TokenType::IDENTIFIER, function, {}, 0};
+  ter_value* result = nullptr;
+  try{
+    std::any callee = interpreter.global->get(name);
+    if(!interpreter.isCallable(callee)){
+      throw RuntimeError{name, "'" + name.lexeme + "' is not a function."};
+    }
+    std::vector<std::any> arguments;
+    arguments.reserve(count);
+    for(size_t i = 0; i < count; ++i){
+      arguments.push_back(args[i] != nullptr ? args[i]->value : std::any{nullptr});
+    }
+    std::any value = interpreter.call(callee, std::move(arguments));
+    // Tasks and async calls it started end with it
+    isolate->isolate.settle();
+    result = wrap(value);
+  }catch(const RuntimeError& error){
+    Debug::runtimeError(error);
+  }catch(const Isolate::Exit&){
+  }catch(...){
+    reportException(isolate);
+  }
+  isolate->isolate.output.flush();
+  collectErrors(isolate);
+  return result;
+}
+
+int ter_register(ter_isolate* isolate, const char* name, int arity, ter_native function, void* data){
+  Isolate::Scope scope{isolate->isolate};
+  Interpreter& interpreter = isolate->isolate.interpreter;
+  if(interpreter.sharedEpoch != 0){
+    isolate->lastError = "Native functions cannot be registered in parallel workers or spawned tasks.";
+    return 1;
+  }
+  try{
+    auto native = std::make_shared<Native>(isolate, name, arity, function, data);
+    interpreter.ownGlobals();
+    interpreter.global->define(name, std::shared_ptr<Callable>(native));
+    interpreter.builtinLabels[native.get()] = name;
+  }catch(const Isolate::Exit& exit){
+    collectErrors(isolate);
+    return exit.code;
+  }catch(...){
+    reportException(isolate);
+    collectErrors(isolate);
+    return 70;
+  }
+  return 0;
+}
+
+ter_value* ter_get_global(ter_isolate* isolate, const char* name){
+  Isolate::Scope scope{isolate->isolate};
+  try{
+    return wrap(isolate->isolate.interpreter.global->get(Token{TokenType::IDENTIFIER, name, {}, 0}));
+  }catch(...){
+    return nullptr;
+  }
+}
+
+int ter_import_native(ter_isolate* isolate, const char* path){
+  Isolate& owner = isolate->isolate;
+  Isolate::Scope scope{owner};
+  isolate->lastError.clear();
+  // Paths with a directory are relative to the script; bare names use the loader's search path
+  std::string file = path;
+  if(file.find('/') != std::string::npos && !owner.dir.empty()){
+    file = (owner.dir / file).string();
+  }
+  // Extensions define globals, which other threads are reading
+  if(owner.interpreter.sharedEpoch != 0){
+    isolate->lastError = "Native extensions cannot be imported in parallel workers or spawned tasks.";
+    return 1;
+  }
+
+#ifdef _WIN32
+  isolate->lastError = "Native extensions are not supported on this platform.";
+  return 1;
+#else
+  // Libraries stay loaded for the whole process: their functions may be referenced anywhere
+  void* library = dlopen(file.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if(library == nullptr){
+    isolate->lastError = dlerror();
+    return 1;
+  }
+  if(owner.extensions.contains(library)){
+    return 0;
+  }
+  auto extension = static_cast<const ter_extension*>(dlsym(library, "ter_extension_info"));
+  if(extension == nullptr){
+    isolate->lastError = "'" + file + "' is not a Ter extension: ter_extension_info is missing.";
+    return 1;
+  }
+  if(extension->api_version < 1 || extension->api_version > TER_API_VERSION){
+    isolate->lastError = "'" + file + "' needs API version " + std::to_string(extension->api_version) +
+      ", this interpreter has " + std::to_string(TER_API_VERSION) + ".";
+    return 1;
+  }
+  int status;
+  try{
+    status = extension->init(isolate);
+  }catch(...){
+    reportException(isolate);
+    collectErrors(isolate);
+    return 70;
+  }
+  if(status != 0){
+    isolate->lastError = "Extension '" + std::string(extension->name) + "' failed to initialize (" + std::to_string(status) + ").";
+    return status;
+  }
+  owner.extensions.insert(library);
+  return 0;
+#endif
+}
+
+const char* ter_last_error(ter_isolate* isolate){
+  return isolate->lastError.c_str();
+}
+
+void ter_error(ter_isolate*, const char* message){
+  if(running != nullptr){
+    running->error = message;
+  }
+}
+
+const char* ter_output(ter_isolate* isolate, size_t* length){
+  isolate->isolate.output.flush();
+  if(length != nullptr) *length = isolate->output.size();
+  return isolate->output.c_str();
+}
+
+void ter_output_clear(ter_isolate* isolate){
+  isolate->isolate.output.flush();
+  isolate->output.clear();
+}
+
+ter_value* ter_null(void){
+  return wrap(nullptr);
+}
+
+ter_value* ter_bool(int value){
+  return wrap(value != 0);
+}
+
+ter_value* ter_number(double value){
+  return wrap(value);
+}
+
+// Sized by the caller, so these may fail to allocate: NULL then
+ter_value* ter_string(const char* text, size_t length){
+  try{
+    return wrap(std::make_shared<StringType>(std::string(text, length)));
+  }catch(...){
+    return nullptr;
+  }
+}
+
+ter_value* ter_string_new(size_t length, char** data){
+  try{
+    auto string = std::make_shared<StringType>(std::string(length, '\0'));
+    // Not hashed or shared yet, so it can still be written
+    *data = const_cast<char*>(string->str().data());
+    return wrap(std::move(string));
+  }catch(...){
+    *data = nullptr;
+    return nullptr;
+  }
+}
+
+ter_value* ter_array(const double* numbers, size_t length){
+  try{
+    return wrap(std::make_shared<ArrayType>(std::vector<double>(numbers, numbers + length)));
+  }catch(...){
+    return nullptr;
+  }
+}
+
+ter_value* ter_array_new(size_t length, double** data){
+  try{
+    auto array = std::make_shared<ArrayType>(std::vector<double>(length));
+    *data = array->numbers.data();
+    return wrap(std::move(array));
+  }catch(...){
+    *data = nullptr;
+    return nullptr;
+  }
+}
+
+ter_value* ter_value_copy(const ter_value* value){
+  return wrap(value->value);
+}
+
+void ter_value_free(ter_value* value){
+  delete value;
+}
+
+ter_type ter_typeof(const ter_value* value){
+  const std::type_info& type = value->value.type();
+  if(type == typeid(bool)) return TER_BOOL;
+  if(type == typeid(double)) return TER_NUMBER;
+  if(type == typeid(std::shared_ptr<StringType>)) return TER_STRING;
+  if(type == typeid(std::shared_ptr<ArrayType>)) return TER_ARRAY;
+  if(type == typeid(std::shared_ptr<Function>) || type == typeid(std::shared_ptr<Callable>)) return TER_FUNCTION;
+  if(type == typeid(std::shared_ptr<Class>)) return TER_CLASS;
+  if(type == typeid(std::shared_ptr<Instance>)) return TER_INSTANCE;
+  return TER_NULL;
+}
+
+double ter_to_number(const ter_value* value){
+  if(value->value.type() == typeid(double)) return std::any_cast<double>(value->value);
+  if(value->value.type() == typeid(bool)) return std::any_cast<bool>(value->value) ? 1.0 : 0.0;
+  return 0.0;
+}
+
+int ter_to_bool(const ter_value* value){
+  // Ter's truthiness: only null and false are false
+  if(value->value.type() == typeid(bool)) return std::any_cast<bool>(value->value) ? 1 : 0;
+  return value->value.type() == typeid(nullptr) || !value->value.has_value() ? 0 : 1;
+}
+
+const char* ter_string_data(const ter_value* value, size_t* length){
+  if(value->value.type() != typeid(std::shared_ptr<StringType>)) return nullptr;
+  const std::string& text = std::any_cast<const std::shared_ptr<StringType>&>(value->value)->str();
+  if(length != nullptr) *length = text.size();
+  return text.c_str();
+}
+
+size_t ter_array_length(const ter_value* value){
+  if(value->value.type() != typeid(std::shared_ptr<ArrayType>)) return 0;
+  return static_cast<size_t>(std::any_cast<const std::shared_ptr<ArrayType>&>(value->value)->length());
+}
+
+ter_value* ter_array_get(const ter_value* value, size_t index){
+  if(index >= ter_array_length(value)) return nullptr;
+  return wrap(std::any_cast<const std::shared_ptr<ArrayType>&>(value->value)->getEleAt(static_cast<int>(index)));
+}
+
+const double* ter_array_view(const ter_value* value, size_t* length){
+  if(value->value.type() != typeid(std::shared_ptr<ArrayType>)) return nullptr;
+  const auto& array = std::any_cast<const std::shared_ptr<ArrayType>&>(value->value);
+  // Frozen arrays were packed before the flag was set
+  if(!array->frozen.load(std::memory_order_acquire) &&
+      !(shared(*array) ? array->isPacked() : array->pack())) return nullptr;
+  if(length != nullptr) *length = array->numbers.size();
+  return array->numbers.data();
+}
+
+double* ter_array_numbers(ter_value* value, size_t* length){
+  if(value->value.type() != typeid(std::shared_ptr<ArrayType>)) return nullptr;
+  const auto& array = std::any_cast<const std::shared_ptr<ArrayType>&>(value->value);
+  // Other threads may be reading a frozen or shared array
+  if(array->frozen.load(std::memory_order_acquire) || shared(*array) || !array->pack()) return nullptr;
+  if(length != nullptr) *length = array->numbers.size();
+  return array->numbers.data();
+}
+
+}
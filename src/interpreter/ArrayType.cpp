@@ -1,18 +1,90 @@
 #include "ArrayType.hpp"
+#include "HeapProfiler.hpp"
+#include "../utils/Stats.hpp"
+
+ArrayType::ArrayType() {
+  ++Stats::get().arrays;
+  if(HeapProfiler::active != nullptr) HeapProfiler::active->track(this, HeapProfiler::Kind::Array);
+}
+
+ArrayType::ArrayType(std::vector<double> numbers) :
+  packed{true}, numbers{std::move(numbers)} {
+  ++Stats::get().arrays;
+  if(HeapProfiler::active != nullptr) HeapProfiler::active->track(this, HeapProfiler::Kind::Array);
+}
+
+ArrayType::~ArrayType(){
+  if(HeapProfiler::active != nullptr) HeapProfiler::active->release(this);
+}
+
+bool ArrayType::isPacked() const {
+  return packed;
+}
+
+void ArrayType::unpack() {
+  if(!packed) return;
+  values.reserve(numbers.size());
+  for(double number : numbers){
+    values.emplace_back(number);
+  }
+  numbers.clear();
+  numbers.shrink_to_fit();
+  packed = false;
+}
+
+bool ArrayType::pack() {
+  if(packed) return true;
+  for(const std::any& value : values){
+    if(value.type() != typeid(double)) return false;
+  }
+  numbers.reserve(values.size());
+  for(const std::any& value : values){
+    numbers.push_back(std::any_cast<double>(value));
+  }
+  values.clear();
+  values.shrink_to_fit();
+  packed = true;
+  return true;
+}
 
 void ArrayType::append(std::any value) {
+  if(packed){
+    if(value.type() == typeid(double)){
+      numbers.push_back(std::any_cast<double>(value));
+      return;
+    }
+    unpack();
+  }
   values.push_back(value);
 }
 
 std::any ArrayType::getEleAt(int index) {
+  if(packed){
+    return numbers.at(static_cast<size_t>(index));
+  }
   return values.at(static_cast<size_t>(index));
 }
 
 int ArrayType::length() {
+  if(packed){
+    return static_cast<int>(numbers.size());
+  }
   return static_cast<int>(values.size());
 }
 
 bool ArrayType::setAtIndex(int index, std::any value) {
+  if(packed){
+    if(value.type() == typeid(double) && index >= 0 && index <= length()){
+      if(index == length()){
+        numbers.push_back(std::any_cast<double>(value));
+      }else{
+        numbers[static_cast<size_t>(index)] = std::any_cast<double>(value);
+      }
+      return true;
+    }
+    unpack();
+  }
+
   if(index == length()){
     values.insert(values.begin() + index, value);
   }else if(index < length() && index >= 0) {
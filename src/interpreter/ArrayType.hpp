@@ -1,14 +1,38 @@
 #pragma once
 
 #include <any>
+#include <atomic>
+#include <cstddef>
 #include <vector>
 
+#include "../utils/Epoch.hpp"
+
+/* Arrays filled only with numbers by native code (bulk builtins, embedders)
+   are kept packed as plain doubles. Storing anything else unpacks them into
+   the generic representation; readers go through the accessors below or
+   check isPacked() before touching values/numbers directly. */
 class ArrayType {
   private:
     void insertAtIndex(int index, std::any value);
+    bool packed = false;
 
   public:
+    const uint64_t epoch = Epoch::now();
+    // Set by freeze() with release once packed; readers on other threads
+    // load it with acquire before touching the elements
+    std::atomic<bool> frozen{false};
+
+    ArrayType();
+    explicit ArrayType(std::vector<double> numbers);
+    ~ArrayType();
+
     std::vector<std::any> values;
+    std::vector<double> numbers;
+
+    bool isPacked() const;
+    void unpack();
+    // Switches to the packed form when every element is a number
+    bool pack();
     void append(std::any value);
     bool setAtIndex(int index, std::any value);
     std::any getEleAt(int index);
@@ -1,13 +1,61 @@
 #include "Builtin.hpp"
 #include "ArrayType.hpp"
+#include "StringType.hpp"
+#include "Function.hpp"
+#include "Class.hpp"
+#include "Instance.hpp"
+#include <algorithm>
+#include <bit>
 #include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
-#include <random>
-#include "../utils/Helpers.hpp"
+#include <unordered_set>
+#include "Isolate.hpp"
+#include "Parallel.hpp"
+#include "Channel.hpp"
+#include "Future.hpp"
+#include "EventLoop.hpp"
+#include "Generator.hpp"
+#include "Range.hpp"
+#include "Worker.hpp"
+#include "../capi/Handles.hpp"
+#include "../utils/Output.hpp"
+#include "../utils/Tracer.hpp"
+#include "../utils/Stats.hpp"
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
 
 void builtinError(const std::string& nameBuiltin){
-    std::cerr << "Builtin '" << nameBuiltin << "' function error.\n";
-    std::exit(1);
+    Isolate& isolate = Isolate::current();
+    isolate.output.flush();
+    isolate.errors << "Builtin '" << nameBuiltin << "' function error.\n";
+    throw Isolate::Exit{1};
+}
+
+// std::isfinite is folded to true under -ffast-math, so test the exponent
+static bool isFinite(double value){
+  constexpr uint64_t exponent = uint64_t{0x7ff} << 52;
+  return (std::bit_cast<uint64_t>(value) & exponent) != exponent;
+}
+
+// Elements a bulk builtin allocates at once; arrays index with int anyway
+static constexpr double maxBulkCount = 1 << 28;
+// Largest magnitude below which every integer is exact as a double
+static constexpr double maxExactInteger = 0x1p53;
+
+// An element count that is safe to allocate
+static bool isCount(double value){
+  return isFinite(value) && value >= 0 && value <= maxBulkCount;
+}
+
+// A number that converts to int64_t without overflow
+static bool isInteger(double value){
+  return isFinite(value) && value >= -maxExactInteger && value <= maxExactInteger;
 }
 
 // ------ Clock -----------
@@ -49,14 +97,9 @@ std::any Rand::call(Interpreter &interpreter, std::vector<std::any> arguments){
   double a = std::any_cast<double>(arguments[0]);
   double b = std::any_cast<double>(arguments[1]);
 
-  std::random_device rd;
-  std::mt19937 gen(rd());
-
-  std::uniform_int_distribution<> dist(static_cast<int>(a), static_cast<int>(b));
+  int64_t random_number = interpreter.random.nextInt(static_cast<int64_t>(a), static_cast<int64_t>(b));
 
-  double random_number = dist(gen);
-
-  return std::any_cast<double>(random_number);
+  return static_cast<double>(random_number);
 }
 
 std::string Rand::toString(){
@@ -73,10 +116,10 @@ std::any GetEnv::call(Interpreter &interpreter, std::vector<std::any> arguments)
     builtinError("getenv");
   }
 
-  std::string name = std::any_cast<std::string>(arguments[0]);
+  const std::string& name = std::any_cast<std::shared_ptr<StringType>>(arguments[0])->str();
   std::string envname = std::getenv(name.data());
 
-  return std::any_cast<std::string>(envname);
+  return std::make_shared<StringType>(std::move(envname));
 }
 
 std::string GetEnv::toString(){
@@ -100,7 +143,7 @@ std::any ToString::call(Interpreter &interpreter, std::vector<std::any> argument
   int terint = static_cast<int>(std::any_cast<double>(arguments[0]));
   std::string str = std::to_string(std::any_cast<int>(terint));
 
-  return std::any_cast<std::string>(str);
+  return std::make_shared<StringType>(std::move(str));
 }
 
 std::string ToString::toString(){
@@ -117,12 +160,18 @@ std::any Args::call(Interpreter &interpreter, std::vector<std::any> arguments){
     builtinError("args");
   }
 
-  std::vector<std::string> args = Helpers::get_instance().get_args();
+  Isolate& isolate = Isolate::current();
   auto arr = std::make_shared<ArrayType>();
+  if(isolate.isWorkerScript){
+    arr->values = isolate.workerArgs;
+    return std::any(arr);
+  }
+
+  const std::vector<std::string>& args = isolate.args;
 
   for(size_t i = 0; i < args.size(); ++i){
     if(i != 0 && i != 1){
-      arr->append(args[i]);
+      arr->append(std::make_shared<StringType>(args[i]));
     }
   }
 
@@ -143,16 +192,34 @@ std::any Exec::call(Interpreter &interpreter, std::vector<std::any> arguments){
     builtinError("exec");
   }
 
-  std::string name = std::any_cast<std::string>(arguments[0]);
-  int run = std::system(name.data());
+  const std::string& name = std::any_cast<std::shared_ptr<StringType>>(arguments[0])->str();
+  Output& out = Output::get_instance();
+  // The child writes straight to stdout: everything printed so far goes first
+  out.flush();
+  Tracer::Span span{"exec", name};
+  int run;
+  if(out.captures()){
+    // Captured isolates (ter --test, embedders) get the child's output too
+    FILE* child = popen(name.data(), "r");
+    if(child == nullptr){
+      builtinError("exec[system]");
+    }
+    char chunk[4096];
+    size_t read;
+    while((read = std::fread(chunk, 1, sizeof(chunk), child)) > 0){
+      out.write(std::string_view{chunk, read});
+    }
+    run = pclose(child);
+  }else{
+    run = std::system(name.data());
+  }
+  span.args = "\"status\":" + std::to_string(run);
   
   if(run != 0){
     builtinError("exec[system]");
   }
 
-  std::string str_run = {};
-
-  return std::any_cast<std::string>(str_run);
+  return StringType::intern("");
 }
 
 std::string Exec::toString(){
@@ -169,12 +236,987 @@ std::any Input::call(Interpreter &interpreter, std::vector<std::any> arguments)
     builtinError("input");
   }
 
+  // Prompts printed with out() must be visible before blocking on input
+  Output::get_instance().flush();
+
   std::string input;
   std::getline(std::cin, input);
 
-  return std::any(input);
+  return std::make_shared<StringType>(std::move(input));
 }
 
 std::string Input::toString() {
   return "<function builtin>";
 }
+
+// Futures are joined by the isolate that spawned them, see Future
+static bool joinable(const std::any& value){
+  return value.type() == typeid(std::shared_ptr<Future>) &&
+    std::any_cast<const std::shared_ptr<Future>&>(value)->ownedBy(Isolate::current());
+}
+
+// ------ Join -----------
+int Join::arity() {
+  return 2;
+}
+
+std::any Join::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  // join(future) waits for a task; join(array, separator) builds a string
+  if(arguments.size() == 1){
+    if(!joinable(arguments[0])){
+      builtinError("join");
+    }
+    return std::any_cast<const std::shared_ptr<Future>&>(arguments[0])->join();
+  }
+
+  if(arguments.size() != (size_t)arity()){
+    builtinError("join");
+  }
+
+  if(arguments[0].type() != typeid(std::shared_ptr<ArrayType>) ||
+      arguments[1].type() != typeid(std::shared_ptr<StringType>)){
+    builtinError("join");
+  }
+
+  auto list = std::any_cast<std::shared_ptr<ArrayType>>(arguments[0]);
+  const std::string& sep = std::any_cast<std::shared_ptr<StringType>>(arguments[1])->str();
+
+  // Size the result once so joining stays linear in the output length
+  size_t total = 0;
+  for(const std::any& value : list->values){
+    if(value.type() == typeid(std::shared_ptr<StringType>)){
+      total += std::any_cast<const std::shared_ptr<StringType>&>(value)->length();
+    }
+    total += sep.length();
+  }
+
+  std::string result;
+  result.reserve(total);
+  int length = list->length();
+  for(int i = 0; i < length; ++i){
+    if(i != 0){
+      result.append(sep);
+    }
+    std::any value = list->getEleAt(i);
+    if(value.type() == typeid(std::shared_ptr<StringType>)){
+      result.append(std::any_cast<const std::shared_ptr<StringType>&>(value)->str());
+    }else{
+      result.append(interpreter.stringify(value));
+    }
+  }
+
+  return std::make_shared<StringType>(std::move(result));
+}
+
+std::string Join::toString() {
+  return "<function builtin>";
+}
+
+// ------ Seed -----------
+int Seed::arity() {
+  return 1;
+}
+
+std::any Seed::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if(arguments.size() != (size_t)arity() || arguments[0].type() != typeid(double)){
+    builtinError("seed");
+  }
+
+  interpreter.random.seed(static_cast<uint64_t>(static_cast<int64_t>(std::any_cast<double>(arguments[0]))));
+  return nullptr;
+}
+
+std::string Seed::toString() {
+  return "<function builtin>";
+}
+
+// ------ RandFloat -----------
+int RandFloat::arity() {
+  return 0;
+}
+
+std::any RandFloat::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if(arguments.size() > (size_t)arity()){
+    builtinError("randf");
+  }
+
+  return interpreter.random.nextDouble();
+}
+
+std::string RandFloat::toString() {
+  return "<function builtin>";
+}
+
+// ------ RandArray -----------
+int RandArray::arity() {
+  return 3;
+}
+
+std::any RandArray::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if(arguments.size() != (size_t)arity()){
+    builtinError("rand_array");
+  }
+
+  for(size_t i = 0; i < (size_t)arity(); i++){
+    if(arguments[i].type() != typeid(double)){
+      builtinError("rand_array");
+    }
+  }
+
+  double count = std::any_cast<double>(arguments[0]);
+  double lowest = std::any_cast<double>(arguments[1]);
+  double highest = std::any_cast<double>(arguments[2]);
+  if(!isCount(count) || !isInteger(lowest) || !isInteger(highest)){
+    builtinError("rand_array");
+  }
+
+  int64_t low = static_cast<int64_t>(lowest);
+  int64_t high = static_cast<int64_t>(highest);
+
+  std::vector<double> numbers(static_cast<size_t>(count));
+  for(double& number : numbers){
+    number = static_cast<double>(interpreter.random.nextInt(low, high));
+  }
+
+  return std::make_shared<ArrayType>(std::move(numbers));
+}
+
+std::string RandArray::toString() {
+  return "<function builtin>";
+}
+
+// ------ RandFloatArray -----------
+int RandFloatArray::arity() {
+  return 1;
+}
+
+std::any RandFloatArray::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if(arguments.size() != (size_t)arity() || arguments[0].type() != typeid(double)){
+    builtinError("randf_array");
+  }
+
+  double count = std::any_cast<double>(arguments[0]);
+  if(!isCount(count)){
+    builtinError("randf_array");
+  }
+
+  std::vector<double> numbers(static_cast<size_t>(count));
+  for(double& number : numbers){
+    number = interpreter.random.nextDouble();
+  }
+
+  return std::make_shared<ArrayType>(std::move(numbers));
+}
+
+std::string RandFloatArray::toString() {
+  return "<function builtin>";
+}
+
+// ------ ClockNs -----------
+int ClockNs::arity() {
+  return 0;
+}
+
+std::any ClockNs::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if(arguments.size() > (size_t)arity() && interpreter.global != nullptr){
+    builtinError("clock_ns");
+  }
+
+  // Monotonic: unaffected by NTP or manual changes of the wall clock
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+}
+
+std::string ClockNs::toString() {
+  return "<function builtin>";
+}
+
+// ------ Stats -----------
+int StatsBuiltin::arity() {
+  return 0;
+}
+
+std::any StatsBuiltin::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if(arguments.size() > (size_t)arity() && interpreter.global != nullptr){
+    builtinError("stats");
+  }
+
+  static auto klass = std::make_shared<Class>("Stats", std::unordered_map<std::string, std::shared_ptr<Function>>{});
+  auto stats = std::make_shared<Instance>(klass);
+  auto ms = [](int64_t ns){ return static_cast<double>(ns) / 1e6; };
+
+  stats->fields = {
+    {"scan_ms", ms(Stats::get().scanNs)},
+    {"parse_ms", ms(Stats::get().parseNs)},
+    {"resolve_ms", ms(Stats::get().resolveNs)},
+    {"run_ms", ms(Stats::elapsedRunNs())},
+    {"tokens", static_cast<double>(Stats::get().tokens)},
+    {"nodes", static_cast<double>(Stats::get().nodes)},
+    {"peak_rss", static_cast<double>(Stats::peakRssBytes())},
+    {"environments", static_cast<double>(Stats::get().environments)},
+    {"instances", static_cast<double>(Stats::get().instances)},
+    {"arrays", static_cast<double>(Stats::get().arrays)},
+    {"strings", static_cast<double>(Stats::get().strings)},
+    {"allocations", static_cast<double>(Stats::allocations())},
+    {"calls", static_cast<double>(Stats::get().calls)},
+    {"exceptions", static_cast<double>(Stats::get().exceptions)}
+  };
+  return stats;
+}
+
+std::string StatsBuiltin::toString() {
+  return "<function builtin>";
+}
+
+// ------ HeapSnapshot -----------
+int HeapSnapshot::arity() {
+  return 1;
+}
+
+std::any HeapSnapshot::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if(arguments.size() != (size_t)arity() || arguments[0].type() != typeid(std::shared_ptr<StringType>)){
+    builtinError("heap_snapshot");
+  }
+
+  // Without --heap-profile there is nothing to report
+  if(interpreter.heapProfiler == nullptr){
+    return false;
+  }
+  return interpreter.heapProfiler->snapshot(std::any_cast<std::shared_ptr<StringType>>(arguments[0])->str());
+}
+
+std::string HeapSnapshot::toString() {
+  return "<function builtin>";
+}
+
+// ------ ImportNative -----------
+int ImportNative::arity() {
+  return 1;
+}
+
+std::any ImportNative::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if((arguments.size() != (size_t)arity() || arguments[0].type() != typeid(std::shared_ptr<StringType>)) &&
+      interpreter.global != nullptr){
+    builtinError("import_native");
+  }
+
+  Isolate& isolate = Isolate::current();
+  ter_isolate* handle = handleOf(isolate);
+  if(ter_import_native(handle, std::any_cast<std::shared_ptr<StringType>>(arguments[0])->str().c_str()) != 0){
+    isolate.output.flush();
+    isolate.errors << ter_last_error(handle) << '\n';
+    builtinError("import_native");
+  }
+  return true;
+}
+
+std::string ImportNative::toString() {
+  return "<function builtin>";
+}
+
+// ------ Bench -----------
+int Bench::arity() {
+  return 2;
+}
+
+std::any Bench::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if(arguments.size() != (size_t)arity() || !interpreter.isCallable(arguments[0]) ||
+      arguments[1].type() != typeid(double) || !isCount(std::any_cast<double>(arguments[1])) ||
+      std::any_cast<double>(arguments[1]) < 1){
+    builtinError("bench");
+  }
+
+  const std::any& function = arguments[0];
+  if(function.type() == typeid(std::shared_ptr<Function>) &&
+      std::any_cast<const std::shared_ptr<Function>&>(function)->arity() != 0){
+    builtinError("bench");
+  }
+
+  using clock = std::chrono::steady_clock;
+  const size_t iterations = static_cast<size_t>(std::any_cast<double>(arguments[1]));
+
+  // Warm up allocators and caches before measuring
+  const size_t warmup = std::max<size_t>(1, iterations / 10);
+  for(size_t i = 0; i < warmup; ++i){
+    interpreter.call(function, {});
+  }
+
+  std::vector<double> samples(iterations);
+  PerfCounters::Sample perfStart = Stats::readPerf();
+  auto begin = clock::now();
+  for(double& sample : samples){
+    auto start = clock::now();
+    interpreter.call(function, {});
+    sample = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+  }
+  double seconds = std::chrono::duration<double>(clock::now() - begin).count();
+  PerfCounters::Sample perf = Stats::readPerf() - perfStart;
+
+  std::sort(samples.begin(), samples.end());
+  double min = std::round(samples.front());
+  double median = std::round(samples[iterations / 2]);
+  double p99 = std::round(samples[std::min(iterations - 1, iterations * 99 / 100)]);
+  double ops = std::round(static_cast<double>(iterations) / seconds);
+
+  Output& out = Output::get_instance();
+  out.write("bench ");
+  out.write(interpreter.stringify(function));
+  out.write(": ");
+  out.writeNumber(static_cast<double>(iterations));
+  out.write(" iterations, min ");
+  out.writeNumber(min);
+  out.write(" ns, median ");
+  out.writeNumber(median);
+  out.write(" ns, p99 ");
+  out.writeNumber(p99);
+  out.write(" ns, ");
+  out.writeNumber(ops);
+  out.write(" ops/sec\n");
+
+  if(PerfCounters::enabled){
+    // Per call, timing overhead included
+    auto perCall = [iterations](uint64_t total){
+      return std::round(static_cast<double>(total) / static_cast<double>(iterations));
+    };
+    out.write("  per call: ");
+    out.writeNumber(perCall(perf.instructions));
+    out.write(" instructions, ");
+    out.writeNumber(perCall(perf.cycles));
+    out.write(" cycles, IPC ");
+    out.writeNumber(std::round(perf.ipc() * 100) / 100);
+    out.write(", ");
+    out.writeNumber(perCall(perf.branchMisses));
+    out.write(" branch misses, ");
+    out.writeNumber(perCall(perf.cacheMisses));
+    out.write(" cache misses\n");
+  }
+
+  return std::make_shared<ArrayType>(std::vector<double>{min, median, p99, ops});
+}
+
+std::string Bench::toString() {
+  return "<function builtin>";
+}
+
+// Functions run by the parallel builtins take the element or index only
+static bool takesOneArgument(Interpreter& interpreter, const std::any& function){
+  if(!interpreter.isCallable(function)) return false;
+  return function.type() != typeid(std::shared_ptr<Function>) ||
+    std::any_cast<const std::shared_ptr<Function>&>(function)->arity() == 1;
+}
+
+// ------ ParallelMap -----------
+int ParallelMap::arity() {
+  return 2;
+}
+
+std::any ParallelMap::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if(arguments.size() != (size_t)arity() || arguments[0].type() != typeid(std::shared_ptr<ArrayType>) ||
+      !takesOneArgument(interpreter, arguments[1])){
+    builtinError("parallel_map");
+  }
+
+  auto list = std::any_cast<std::shared_ptr<ArrayType>>(arguments[0]);
+  std::vector<std::any> inputs;
+  inputs.reserve(static_cast<size_t>(list->length()));
+  for(int i = 0; i < list->length(); ++i){
+    inputs.push_back(list->getEleAt(i));
+  }
+
+  std::vector<std::any> results = Parallel::map(arguments[1], inputs);
+  auto array = std::make_shared<ArrayType>();
+  array->values = std::move(results);
+  array->pack();
+  return array;
+}
+
+std::string ParallelMap::toString() {
+  return "<function builtin>";
+}
+
+// ------ ParallelFor -----------
+int ParallelFor::arity() {
+  return 3;
+}
+
+std::any ParallelFor::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if(arguments.size() != (size_t)arity() || arguments[0].type() != typeid(double) ||
+      arguments[1].type() != typeid(double) || !takesOneArgument(interpreter, arguments[2])){
+    builtinError("parallel_for");
+  }
+
+  double from = std::any_cast<double>(arguments[0]);
+  double to = std::any_cast<double>(arguments[1]);
+  std::vector<std::any> inputs;
+  for(double i = from; i < to; ++i){
+    inputs.push_back(i);
+  }
+
+  Parallel::map(arguments[2], inputs);
+  return nullptr;
+}
+
+std::string ParallelFor::toString() {
+  return "<function builtin>";
+}
+
+// ------ ChannelBuiltin -----------
+int ChannelBuiltin::arity() {
+  return 1;
+}
+
+std::any ChannelBuiltin::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if(arguments.size() > (size_t)arity() && interpreter.global != nullptr){
+    builtinError("channel");
+  }
+
+  double capacity = static_cast<double>(Channel::defaultCapacity);
+  if(!arguments.empty()){
+    if(arguments[0].type() != typeid(double)){
+      builtinError("channel");
+    }
+    capacity = std::any_cast<double>(arguments[0]);
+    // Nothing out of range may reach the cast below
+    if(!isFinite(capacity) || capacity < 1 || capacity > static_cast<double>(Channel::maxCapacity)){
+      builtinError("channel");
+    }
+  }
+  return std::make_shared<Channel>(static_cast<size_t>(capacity));
+}
+
+std::string ChannelBuiltin::toString() {
+  return "<function builtin>";
+}
+
+// ------ Send -----------
+int Send::arity() {
+  return 2;
+}
+
+std::any Send::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if((arguments.size() != (size_t)arity() || arguments[0].type() != typeid(std::shared_ptr<Channel>)) &&
+      interpreter.global != nullptr){
+    builtinError("send");
+  }
+
+  Message message;
+  if(!Channel::copy(arguments[1], message) ||
+      !std::any_cast<const std::shared_ptr<Channel>&>(arguments[0])->send(std::move(message))){
+    builtinError("send");
+  }
+  return nullptr;
+}
+
+std::string Send::toString() {
+  return "<function builtin>";
+}
+
+// ------ Recv -----------
+int Recv::arity() {
+  return 1;
+}
+
+std::any Recv::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if((arguments.size() != (size_t)arity() || arguments[0].type() != typeid(std::shared_ptr<Channel>)) &&
+      interpreter.global != nullptr){
+    builtinError("recv");
+  }
+
+  return std::any_cast<const std::shared_ptr<Channel>&>(arguments[0])->receive();
+}
+
+std::string Recv::toString() {
+  return "<function builtin>";
+}
+
+// ------ Close -----------
+int Close::arity() {
+  return 1;
+}
+
+std::any Close::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if((arguments.size() != (size_t)arity() || arguments[0].type() != typeid(std::shared_ptr<Channel>)) &&
+      interpreter.global != nullptr){
+    builtinError("close");
+  }
+
+  std::any_cast<const std::shared_ptr<Channel>&>(arguments[0])->close();
+  return nullptr;
+}
+
+std::string Close::toString() {
+  return "<function builtin>";
+}
+
+// ------ SpawnWorker -----------
+int SpawnWorker::arity() {
+  return 1;
+}
+
+std::any SpawnWorker::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if(arguments.empty()){
+    builtinError("spawn_worker");
+  }
+
+  // The worker gets copies of everything after the target
+  Bundle values;
+  for(size_t i = 1; i < arguments.size(); ++i){
+    if(!values.add(arguments[i])){
+      builtinError("spawn_worker");
+    }
+  }
+
+  Isolate& isolate = Isolate::current();
+  const std::any& target = arguments[0];
+  // What the caller printed so far comes before anything the worker prints
+  isolate.output.flush();
+
+  if(target.type() == typeid(std::shared_ptr<StringType>)){
+    std::filesystem::path path = std::any_cast<const std::shared_ptr<StringType>&>(target)->str();
+    if(path.is_relative()){
+      path = isolate.dir / path;
+    }
+    isolate.workers.push_back(std::make_unique<Worker>(isolate, path, std::move(values)));
+    return nullptr;
+  }
+
+  if(target.type() != typeid(std::shared_ptr<Function>) && interpreter.global != nullptr){
+    builtinError("spawn_worker");
+  }
+  const auto& function = std::any_cast<const std::shared_ptr<Function>&>(target);
+  std::shared_ptr<Env> closure = function->getClosure();
+  if(static_cast<size_t>(function->arity()) != values.values.size() || closure == nullptr || !closure->isGlobal()){
+    builtinError("spawn_worker");
+  }
+  isolate.workers.push_back(std::make_unique<Worker>(isolate, target, std::move(values)));
+  return nullptr;
+}
+
+std::string SpawnWorker::toString() {
+  return "<function builtin>";
+}
+
+// Code another thread can call: it captures no live local variables
+static bool sharesNoLocals(const std::shared_ptr<Function>& function){
+  std::shared_ptr<Env> closure = function->getClosure();
+  return closure == nullptr || closure->isGlobal();
+}
+
+static bool sharesNoLocals(const std::shared_ptr<Class>& klass){
+  for(const auto& [name, method] : klass->methods){
+    if(!sharesNoLocals(method)) return false;
+  }
+  return true;
+}
+
+// Arrays and instances freeze() marks; fails if it reaches code that
+// captures locals
+static bool collectFrozen(const std::any& value, std::vector<std::any>& objects,
+    std::unordered_set<const void*>& seen){
+  if(value.type() == typeid(std::shared_ptr<Function>)){
+    return sharesNoLocals(std::any_cast<const std::shared_ptr<Function>&>(value));
+  }
+  if(value.type() == typeid(std::shared_ptr<Class>)){
+    return sharesNoLocals(std::any_cast<const std::shared_ptr<Class>&>(value));
+  }
+  if(value.type() == typeid(std::shared_ptr<ArrayType>)){
+    const auto& array = std::any_cast<const std::shared_ptr<ArrayType>&>(value);
+    if(array->frozen.load(std::memory_order_acquire) || !seen.insert(array.get()).second) return true;
+    objects.push_back(value);
+    for(const std::any& element : array->values){
+      if(!collectFrozen(element, objects, seen)) return false;
+    }
+    return true;
+  }
+  if(value.type() == typeid(std::shared_ptr<Instance>)){
+    const auto& instance = std::any_cast<const std::shared_ptr<Instance>&>(value);
+    if(instance->frozen.load(std::memory_order_acquire) || !seen.insert(instance.get()).second) return true;
+    if(!sharesNoLocals(instance->klass)) return false;
+    objects.push_back(value);
+    for(const auto& [name, field] : instance->fields){
+      if(!collectFrozen(field, objects, seen)) return false;
+    }
+    return true;
+  }
+  return true;
+}
+
+// ------ Freeze -----------
+int Freeze::arity() {
+  return 1;
+}
+
+std::any Freeze::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if(arguments.size() != (size_t)arity() && interpreter.global != nullptr){
+    builtinError("freeze");
+  }
+
+  std::vector<std::any> objects;
+  std::unordered_set<const void*> seen;
+  if(!collectFrozen(arguments[0], objects, seen)){
+    builtinError("freeze");
+  }
+  // Workers and tasks may only freeze what they created: anything older is
+  // read by other threads while pack() rewrites it
+  if(interpreter.sharedEpoch != 0){
+    for(const std::any& object : objects){
+      uint64_t epoch = object.type() == typeid(std::shared_ptr<ArrayType>) ?
+        std::any_cast<const std::shared_ptr<ArrayType>&>(object)->epoch :
+        std::any_cast<const std::shared_ptr<Instance>&>(object)->epoch;
+      if(epoch < interpreter.sharedEpoch) builtinError("freeze");
+    }
+  }
+  for(const std::any& object : objects){
+    if(object.type() == typeid(std::shared_ptr<ArrayType>)){
+      const auto& array = std::any_cast<const std::shared_ptr<ArrayType>&>(object);
+      // Packed now, so no reader ever has to convert it; the release store
+      // publishes the packed elements to threads that see the flag
+      array->pack();
+      array->frozen.store(true, std::memory_order_release);
+    }else{
+      const auto& instance = std::any_cast<const std::shared_ptr<Instance>&>(object);
+      instance->frozen.store(true, std::memory_order_release);
+    }
+  }
+  return arguments[0];
+}
+
+std::string Freeze::toString() {
+  return "<function builtin>";
+}
+
+// ------ IsFrozen -----------
+int IsFrozen::arity() {
+  return 1;
+}
+
+std::any IsFrozen::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if(arguments.size() != (size_t)arity() && interpreter.global != nullptr){
+    builtinError("is_frozen");
+  }
+
+  const std::any& value = arguments[0];
+  if(value.type() == typeid(std::shared_ptr<ArrayType>)){
+    return std::any_cast<const std::shared_ptr<ArrayType>&>(value)->frozen.load(std::memory_order_acquire);
+  }
+  if(value.type() == typeid(std::shared_ptr<Instance>)){
+    return std::any_cast<const std::shared_ptr<Instance>&>(value)->frozen.load(std::memory_order_acquire);
+  }
+  // Everything else cannot be modified anyway
+  return true;
+}
+
+std::string IsFrozen::toString() {
+  return "<function builtin>";
+}
+
+// ------ Spawn -----------
+int Spawn::arity() {
+  return 1;
+}
+
+std::any Spawn::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if((arguments.empty() || !interpreter.isCallable(arguments[0])) && interpreter.global != nullptr){
+    builtinError("spawn");
+  }
+
+  std::any function = std::move(arguments[0]);
+  arguments.erase(arguments.begin());
+  // The task runs on another thread: it cannot share the caller's locals
+  if(function.type() == typeid(std::shared_ptr<Function>)){
+    const auto& target = std::any_cast<const std::shared_ptr<Function>&>(function);
+    if(static_cast<size_t>(target->arity()) != arguments.size() || !sharesNoLocals(target)){
+      builtinError("spawn");
+    }
+  }else if(function.type() == typeid(std::shared_ptr<Class>) &&
+      !sharesNoLocals(std::any_cast<const std::shared_ptr<Class>&>(function))){
+    builtinError("spawn");
+  }
+
+  std::shared_ptr<Future> future = Future::spawn(function, arguments);
+  if(future == nullptr){
+    builtinError("spawn");
+  }
+  return future;
+}
+
+std::string Spawn::toString() {
+  return "<function builtin>";
+}
+
+// ------ JoinAll -----------
+int JoinAll::arity() {
+  return 1;
+}
+
+std::any JoinAll::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if((arguments.size() != (size_t)arity() || arguments[0].type() != typeid(std::shared_ptr<ArrayType>)) &&
+      interpreter.global != nullptr){
+    builtinError("join_all");
+  }
+
+  auto list = std::any_cast<std::shared_ptr<ArrayType>>(arguments[0]);
+  // Checked up front, so a bad element does not leave the rest half joined
+  std::vector<std::shared_ptr<Future>> futures;
+  for(int i = 0; i < list->length(); ++i){
+    std::any element = list->getEleAt(i);
+    if(!joinable(element)){
+      builtinError("join_all");
+    }
+    futures.push_back(std::any_cast<std::shared_ptr<Future>>(element));
+  }
+
+  auto results = std::make_shared<ArrayType>();
+  results->values.reserve(futures.size());
+  for(const std::shared_ptr<Future>& future : futures){
+    results->values.push_back(future->join());
+  }
+  results->pack();
+  return results;
+}
+
+std::string JoinAll::toString() {
+  return "<function builtin>";
+}
+
+static bool awaitable(const std::any& value){
+  return value.type() == typeid(std::shared_ptr<Promise>) &&
+    std::any_cast<const std::shared_ptr<Promise>&>(value)->ownedBy(Isolate::current().loop.get());
+}
+
+static bool isString(const std::any& value){
+  return value.type() == typeid(std::shared_ptr<StringType>);
+}
+
+// ------ Await -----------
+int Await::arity() {
+  return 1;
+}
+
+std::any Await::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if(arguments.size() != (size_t)arity() && interpreter.global != nullptr){
+    builtinError("await");
+  }
+
+  // Anything but a promise is already a value
+  if(arguments[0].type() != typeid(std::shared_ptr<Promise>)){
+    return arguments[0];
+  }
+  if(!awaitable(arguments[0])){
+    builtinError("await");
+  }
+  return Isolate::current().eventLoop().await(std::any_cast<std::shared_ptr<Promise>>(arguments[0]));
+}
+
+std::string Await::toString() {
+  return "<function builtin>";
+}
+
+// ------ AwaitAll -----------
+int AwaitAll::arity() {
+  return 1;
+}
+
+std::any AwaitAll::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if((arguments.size() != (size_t)arity() || arguments[0].type() != typeid(std::shared_ptr<ArrayType>)) &&
+      interpreter.global != nullptr){
+    builtinError("await_all");
+  }
+
+  auto list = std::any_cast<std::shared_ptr<ArrayType>>(arguments[0]);
+  std::vector<std::any> elements;
+  for(int i = 0; i < list->length(); ++i){
+    elements.push_back(list->getEleAt(i));
+    if(elements.back().type() == typeid(std::shared_ptr<Promise>) && !awaitable(elements.back())){
+      builtinError("await_all");
+    }
+  }
+
+  // All of them run meanwhile, so this waits as long as the slowest
+  auto results = std::make_shared<ArrayType>();
+  results->values.reserve(elements.size());
+  for(std::any& element : elements){
+    if(element.type() == typeid(std::shared_ptr<Promise>)){
+      results->values.push_back(Isolate::current().eventLoop().await(std::any_cast<std::shared_ptr<Promise>>(element)));
+    }else{
+      results->values.push_back(std::move(element));
+    }
+  }
+  results->pack();
+  return results;
+}
+
+std::string AwaitAll::toString() {
+  return "<function builtin>";
+}
+
+// ------ SleepAsync -----------
+int SleepAsync::arity() {
+  return 1;
+}
+
+std::any SleepAsync::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if((arguments.size() != (size_t)arity() || arguments[0].type() != typeid(double)) &&
+      interpreter.global != nullptr){
+    builtinError("sleep_async");
+  }
+  double milliseconds = std::any_cast<double>(arguments[0]);
+  if(!isFinite(milliseconds) || milliseconds < 0 || milliseconds > EventLoop::maxSleep){
+    builtinError("sleep_async");
+  }
+  return Isolate::current().eventLoop().sleep(milliseconds);
+}
+
+std::string SleepAsync::toString() {
+  return "<function builtin>";
+}
+
+// ------ ExecAsync -----------
+int ExecAsync::arity() {
+  return 1;
+}
+
+std::any ExecAsync::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if((arguments.size() != (size_t)arity() || !isString(arguments[0])) && interpreter.global != nullptr){
+    builtinError("exec_async");
+  }
+  // Unlike exec(), the child's stdout is captured, so nothing needs flushing
+  return Isolate::current().eventLoop().exec(std::any_cast<std::shared_ptr<StringType>>(arguments[0])->str());
+}
+
+std::string ExecAsync::toString() {
+  return "<function builtin>";
+}
+
+// ------ ReadAsync -----------
+int ReadAsync::arity() {
+  return 1;
+}
+
+std::any ReadAsync::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if((arguments.size() != (size_t)arity() || !isString(arguments[0])) && interpreter.global != nullptr){
+    builtinError("read_async");
+  }
+  return Isolate::current().eventLoop().readFile(std::any_cast<std::shared_ptr<StringType>>(arguments[0])->str());
+}
+
+std::string ReadAsync::toString() {
+  return "<function builtin>";
+}
+
+// ------ WriteAsync -----------
+int WriteAsync::arity() {
+  return 2;
+}
+
+std::any WriteAsync::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if((arguments.size() != (size_t)arity() || !isString(arguments[0]) || !isString(arguments[1])) &&
+      interpreter.global != nullptr){
+    builtinError("write_async");
+  }
+  return Isolate::current().eventLoop().writeFile(
+    std::any_cast<std::shared_ptr<StringType>>(arguments[0])->str(),
+    std::any_cast<std::shared_ptr<StringType>>(arguments[1])->str());
+}
+
+std::string WriteAsync::toString() {
+  return "<function builtin>";
+}
+
+// ------ InputAsync -----------
+int InputAsync::arity() {
+  return 0;
+}
+
+std::any InputAsync::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if(arguments.size() > (size_t)arity() && interpreter.global != nullptr){
+    builtinError("input_async");
+  }
+  // Prompts printed with out() must be visible before the line is read
+  Isolate::current().output.flush();
+  return Isolate::current().eventLoop().readLine();
+}
+
+std::string InputAsync::toString() {
+  return "<function builtin>";
+}
+
+// ------ Next -----------
+int Next::arity() {
+  return 1;
+}
+
+std::any Next::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if((arguments.size() != (size_t)arity() || arguments[0].type() != typeid(std::shared_ptr<Generator>)) &&
+      interpreter.global != nullptr){
+    builtinError("next");
+  }
+
+  auto generator = std::any_cast<std::shared_ptr<Generator>>(arguments[0]);
+  if(!generator->resumable()){
+    builtinError("next");
+  }
+  // Ter variables cannot hold nil, so the end is false, as for recv()
+  if(!generator->next()) return false;
+  return generator->value();
+}
+
+std::string Next::toString() {
+  return "<function builtin>";
+}
+
+// ------ ReadLines -----------
+int ReadLines::arity() {
+  return 1;
+}
+
+std::any ReadLines::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if((arguments.size() != (size_t)arity() || !isString(arguments[0])) && interpreter.global != nullptr){
+    builtinError("read_lines");
+  }
+
+  auto file = std::make_shared<std::ifstream>(std::any_cast<std::shared_ptr<StringType>>(arguments[0])->str());
+  if(!*file){
+    builtinError("read_lines");
+  }
+  // One line in memory at a time, however large the file
+  return std::make_shared<Generator>(Isolate::current(), [file]{
+    std::string line;
+    while(std::getline(*file, line)){
+      Generator::yield(std::make_shared<StringType>(line));
+    }
+  });
+}
+
+std::string ReadLines::toString() {
+  return "<function builtin>";
+}
+
+// ------ MakeRange -----------
+int MakeRange::arity() {
+  return 3;
+}
+
+// range(stop), range(start, stop) or range(start, stop, step)
+std::any MakeRange::call(Interpreter &interpreter, std::vector<std::any> arguments) {
+  if((arguments.empty() || arguments.size() > (size_t)arity()) && interpreter.global != nullptr){
+    builtinError("range");
+  }
+  for(const std::any& argument : arguments){
+    if(argument.type() != typeid(double)){
+      builtinError("range");
+    }
+  }
+
+  double start = arguments.size() > 1 ? std::any_cast<double>(arguments[0]) : 0;
+  double stop = std::any_cast<double>(arguments[arguments.size() > 1 ? 1 : 0]);
+  double step = arguments.size() > 2 ? std::any_cast<double>(arguments[2]) : 1;
+  if(step == 0 || !isFinite(start) || !isFinite(stop) || !isFinite(step)){
+    builtinError("range");
+  }
+  return std::make_shared<Range>(start, stop, step);
+}
+
+std::string MakeRange::toString() {
+  return "<function builtin>";
+}
@@ -2,6 +2,9 @@
 #include "Callable.hpp"
 #include "Interpreter.hpp"
 
+// Reports a failed builtin and stops the isolate
+void builtinError(const std::string& nameBuiltin);
+
 class Clock : public Callable {
   public:
     int arity() override;
@@ -50,3 +53,220 @@ class Input : public Callable {
     std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
     std::string toString() override;
 };
+
+class Join : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class Seed : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class RandFloat : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class RandArray : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class RandFloatArray : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class ClockNs : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class StatsBuiltin : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class HeapSnapshot : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class ImportNative : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class Bench : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class ParallelMap : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class ParallelFor : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class ChannelBuiltin : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class Send : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class Recv : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class Close : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class SpawnWorker : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class Freeze : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class IsFrozen : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class Spawn : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class JoinAll : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class Await : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class AwaitAll : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class SleepAsync : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class ExecAsync : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class ReadAsync : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class WriteAsync : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class InputAsync : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class Next : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class ReadLines : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
+
+class MakeRange : public Callable {
+  public:
+    int arity() override;
+    std::any call(Interpreter &interpreter, std::vector<std::any> arguments) override;
+    std::string toString() override;
+};
@@ -9,7 +9,38 @@ std::unordered_map<std::type_index, std::function<std::shared_ptr<Callable>()>>
     {typeid(std::shared_ptr<ToString>), [](){ return std::make_shared<ToString>(); }},
     {typeid(std::shared_ptr<Args>), [](){ return std::make_shared<Args>(); }},
     {typeid(std::shared_ptr<Exec>), [](){ return std::make_shared<Exec>(); }},
-    {typeid(std::shared_ptr<Input>), [](){ return std::make_shared<Input>(); }}
+    {typeid(std::shared_ptr<Input>), [](){ return std::make_shared<Input>(); }},
+    {typeid(std::shared_ptr<Join>), [](){ return std::make_shared<Join>(); }},
+    {typeid(std::shared_ptr<Seed>), [](){ return std::make_shared<Seed>(); }},
+    {typeid(std::shared_ptr<RandFloat>), [](){ return std::make_shared<RandFloat>(); }},
+    {typeid(std::shared_ptr<RandArray>), [](){ return std::make_shared<RandArray>(); }},
+    {typeid(std::shared_ptr<RandFloatArray>), [](){ return std::make_shared<RandFloatArray>(); }},
+    {typeid(std::shared_ptr<ClockNs>), [](){ return std::make_shared<ClockNs>(); }},
+    {typeid(std::shared_ptr<Bench>), [](){ return std::make_shared<Bench>(); }},
+    {typeid(std::shared_ptr<StatsBuiltin>), [](){ return std::make_shared<StatsBuiltin>(); }},
+    {typeid(std::shared_ptr<HeapSnapshot>), [](){ return std::make_shared<HeapSnapshot>(); }},
+    {typeid(std::shared_ptr<ImportNative>), [](){ return std::make_shared<ImportNative>(); }},
+    {typeid(std::shared_ptr<ParallelMap>), [](){ return std::make_shared<ParallelMap>(); }},
+    {typeid(std::shared_ptr<ParallelFor>), [](){ return std::make_shared<ParallelFor>(); }},
+    {typeid(std::shared_ptr<ChannelBuiltin>), [](){ return std::make_shared<ChannelBuiltin>(); }},
+    {typeid(std::shared_ptr<Send>), [](){ return std::make_shared<Send>(); }},
+    {typeid(std::shared_ptr<Recv>), [](){ return std::make_shared<Recv>(); }},
+    {typeid(std::shared_ptr<Close>), [](){ return std::make_shared<Close>(); }},
+    {typeid(std::shared_ptr<SpawnWorker>), [](){ return std::make_shared<SpawnWorker>(); }},
+    {typeid(std::shared_ptr<Freeze>), [](){ return std::make_shared<Freeze>(); }},
+    {typeid(std::shared_ptr<IsFrozen>), [](){ return std::make_shared<IsFrozen>(); }},
+    {typeid(std::shared_ptr<Spawn>), [](){ return std::make_shared<Spawn>(); }},
+    {typeid(std::shared_ptr<JoinAll>), [](){ return std::make_shared<JoinAll>(); }},
+    {typeid(std::shared_ptr<Await>), [](){ return std::make_shared<Await>(); }},
+    {typeid(std::shared_ptr<AwaitAll>), [](){ return std::make_shared<AwaitAll>(); }},
+    {typeid(std::shared_ptr<SleepAsync>), [](){ return std::make_shared<SleepAsync>(); }},
+    {typeid(std::shared_ptr<ExecAsync>), [](){ return std::make_shared<ExecAsync>(); }},
+    {typeid(std::shared_ptr<ReadAsync>), [](){ return std::make_shared<ReadAsync>(); }},
+    {typeid(std::shared_ptr<WriteAsync>), [](){ return std::make_shared<WriteAsync>(); }},
+    {typeid(std::shared_ptr<InputAsync>), [](){ return std::make_shared<InputAsync>(); }},
+    {typeid(std::shared_ptr<Next>), [](){ return std::make_shared<Next>(); }},
+    {typeid(std::shared_ptr<ReadLines>), [](){ return std::make_shared<ReadLines>(); }},
+    {typeid(std::shared_ptr<MakeRange>), [](){ return std::make_shared<MakeRange>(); }}
 };
 
 // Map of built-in function names
@@ -20,5 +51,36 @@ std::unordered_map<std::string, std::type_index> builtinNames = {
     {"to_string", typeid(std::shared_ptr<ToString>)},
     {"args", typeid(std::shared_ptr<Args>)},
     {"exec", typeid(std::shared_ptr<Exec>)},
-    {"input", typeid(std::shared_ptr<Input>)}
+    {"input", typeid(std::shared_ptr<Input>)},
+    {"join", typeid(std::shared_ptr<Join>)},
+    {"seed", typeid(std::shared_ptr<Seed>)},
+    {"randf", typeid(std::shared_ptr<RandFloat>)},
+    {"rand_array", typeid(std::shared_ptr<RandArray>)},
+    {"randf_array", typeid(std::shared_ptr<RandFloatArray>)},
+    {"clock_ns", typeid(std::shared_ptr<ClockNs>)},
+    {"bench", typeid(std::shared_ptr<Bench>)},
+    {"stats", typeid(std::shared_ptr<StatsBuiltin>)},
+    {"heap_snapshot", typeid(std::shared_ptr<HeapSnapshot>)},
+    {"import_native", typeid(std::shared_ptr<ImportNative>)},
+    {"parallel_map", typeid(std::shared_ptr<ParallelMap>)},
+    {"parallel_for", typeid(std::shared_ptr<ParallelFor>)},
+    {"channel", typeid(std::shared_ptr<ChannelBuiltin>)},
+    {"send", typeid(std::shared_ptr<Send>)},
+    {"recv", typeid(std::shared_ptr<Recv>)},
+    {"close", typeid(std::shared_ptr<Close>)},
+    {"spawn_worker", typeid(std::shared_ptr<SpawnWorker>)},
+    {"freeze", typeid(std::shared_ptr<Freeze>)},
+    {"is_frozen", typeid(std::shared_ptr<IsFrozen>)},
+    {"spawn", typeid(std::shared_ptr<Spawn>)},
+    {"join_all", typeid(std::shared_ptr<JoinAll>)},
+    {"await", typeid(std::shared_ptr<Await>)},
+    {"await_all", typeid(std::shared_ptr<AwaitAll>)},
+    {"sleep_async", typeid(std::shared_ptr<SleepAsync>)},
+    {"exec_async", typeid(std::shared_ptr<ExecAsync>)},
+    {"read_async", typeid(std::shared_ptr<ReadAsync>)},
+    {"write_async", typeid(std::shared_ptr<WriteAsync>)},
+    {"input_async", typeid(std::shared_ptr<InputAsync>)},
+    {"next", typeid(std::shared_ptr<Next>)},
+    {"read_lines", typeid(std::shared_ptr<ReadLines>)},
+    {"range", typeid(std::shared_ptr<MakeRange>)}
 };
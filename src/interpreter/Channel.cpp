@@ -0,0 +1,298 @@
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Channel.hpp"
+#include "ArrayType.hpp"
+#include "Class.hpp"
+#include "EventLoop.hpp"
+#include "Function.hpp"
+#include "Future.hpp"
+#include "Generator.hpp"
+#include "Instance.hpp"
+#include "StringType.hpp"
+#include "Isolate.hpp"
+
+namespace {
+  // Rounds of yielding before a waiting thread goes to sleep
+  constexpr int spinRounds = 64;
+
+  bool declaredAtTopLevel(const std::shared_ptr<Function>& function){
+    std::shared_ptr<Env> closure = function->getClosure();
+    return closure == nullptr || closure->isGlobal();
+  }
+}
+
+// Copies shared objects once, so aliasing and cycles survive the trip
+class Copier {
+  public:
+    bool hasCode = false;
+
+    bool copy(const std::any& value, std::any& result){
+      const std::type_info& type = value.type();
+      if(type == typeid(std::shared_ptr<ArrayType>)){
+        return copyArray(std::any_cast<const std::shared_ptr<ArrayType>&>(value), result);
+      }
+      if(type == typeid(std::shared_ptr<Instance>)){
+        return copyInstance(std::any_cast<const std::shared_ptr<Instance>&>(value), result);
+      }
+      if(type == typeid(std::shared_ptr<Function>)){
+        if(!declaredAtTopLevel(std::any_cast<const std::shared_ptr<Function>&>(value))) return false;
+        hasCode = true;
+      }else if(type == typeid(std::shared_ptr<Generator>)){
+        // Its body runs on the stack of the thread that created it
+        return false;
+      }else if(type == typeid(std::shared_ptr<Future>) || type == typeid(std::shared_ptr<Promise>)){
+        // Only the isolate that started them may wait for them
+        return false;
+      }else if(type == typeid(std::shared_ptr<Class>)){
+        for(auto& [name, method] : std::any_cast<const std::shared_ptr<Class>&>(value)->methods){
+          if(!declaredAtTopLevel(method)) return false;
+        }
+        hasCode = true;
+      }
+      // Numbers, booleans, nil, strings, ranges, channels, builtins and top-level code
+      result = value;
+      return true;
+    }
+
+    size_t copied() const {
+      return order.size();
+    }
+
+    // Forgets the copies made since copied() returned count: after a failed
+    // copy they may be incomplete
+    void rollback(size_t count){
+      while(order.size() > count){
+        copies.erase(order.back());
+        order.pop_back();
+      }
+    }
+
+  private:
+    std::unordered_map<const void*, std::any> copies;
+    std::vector<const void*> order;
+
+    void remember(const void* original, const std::any& copy){
+      copies.emplace(original, copy);
+      order.push_back(original);
+    }
+
+    bool copyArray(const std::shared_ptr<ArrayType>& array, std::any& result){
+      if(array->frozen.load(std::memory_order_acquire)){
+        result = array;
+        return true;
+      }
+      auto known = copies.find(array.get());
+      if(known != copies.end()){
+        result = known->second;
+        return true;
+      }
+      if(array->isPacked()){
+        result = std::make_shared<ArrayType>(array->numbers);
+        remember(array.get(), result);
+        return true;
+      }
+      auto copied = std::make_shared<ArrayType>();
+      result = copied;
+      remember(array.get(), result);
+      copied->values.resize(array->values.size());
+      for(size_t i = 0; i < array->values.size(); ++i){
+        if(!copy(array->values[i], copied->values[i])) return false;
+      }
+      return true;
+    }
+
+    bool copyInstance(const std::shared_ptr<Instance>& instance, std::any& result){
+      if(instance->frozen.load(std::memory_order_acquire)){
+        result = instance;
+        return true;
+      }
+      auto known = copies.find(instance.get());
+      if(known != copies.end()){
+        result = known->second;
+        return true;
+      }
+      std::any klass;
+      if(!copy(instance->klass, klass)) return false;
+      auto copied = std::make_shared<Instance>(instance->klass);
+      hasCode = true;
+      result = copied;
+      remember(instance.get(), result);
+      for(auto& [name, field] : instance->fields){
+        if(!copy(field, copied->fields[name])) return false;
+      }
+      return true;
+    }
+};
+
+namespace {
+  // Points top-level code at the receiving isolate's globals: left alone,
+  // it would keep reading and writing the sender's
+  class Adopter {
+    public:
+      explicit Adopter(std::shared_ptr<Env> receiver) : global{std::move(receiver)} {}
+
+      void adopt(std::any& value){
+        const std::type_info& type = value.type();
+        if(type == typeid(std::shared_ptr<Function>)){
+          value = adoptFunction(std::any_cast<const std::shared_ptr<Function>&>(value));
+        }else if(type == typeid(std::shared_ptr<Class>)){
+          value = adoptClass(std::any_cast<const std::shared_ptr<Class>&>(value));
+        }else if(type == typeid(std::shared_ptr<ArrayType>)){
+          const auto& array = std::any_cast<const std::shared_ptr<ArrayType>&>(value);
+          if(array->frozen.load(std::memory_order_acquire) || array->isPacked() ||
+              !visited.insert(array.get()).second) return;
+          for(std::any& element : array->values){
+            adopt(element);
+          }
+        }else if(type == typeid(std::shared_ptr<Instance>)){
+          const auto& instance = std::any_cast<const std::shared_ptr<Instance>&>(value);
+          // Frozen ones are shared, not owned: their code stays as it is
+          if(instance->frozen.load(std::memory_order_acquire) || !visited.insert(instance.get()).second) return;
+          instance->klass = adoptClass(instance->klass);
+          for(auto& [name, field] : instance->fields){
+            adopt(field);
+          }
+        }
+      }
+
+    private:
+      std::shared_ptr<Env> global;
+      std::unordered_set<const void*> visited;
+      std::unordered_map<const void*, std::shared_ptr<Function>> functions;
+      std::unordered_map<const void*, std::shared_ptr<Class>> classes;
+
+      std::shared_ptr<Function> adoptFunction(const std::shared_ptr<Function>& function){
+        std::shared_ptr<Env> closure = function->getClosure();
+        if(closure == nullptr || closure == global) return function;
+        std::shared_ptr<Function>& adopted = functions[function.get()];
+        if(adopted == nullptr){
+          adopted = std::make_shared<Function>(function->getDeclaration(), global);
+        }
+        return adopted;
+      }
+
+      std::shared_ptr<Class> adoptClass(const std::shared_ptr<Class>& klass){
+        std::shared_ptr<Class>& adopted = classes[klass.get()];
+        if(adopted == nullptr){
+          std::unordered_map<std::string, std::shared_ptr<Function>> methods;
+          for(auto& [name, method] : klass->methods){
+            methods.emplace(name, adoptFunction(method));
+          }
+          adopted = std::make_shared<Class>(klass->name, std::move(methods));
+        }
+        return adopted;
+      }
+  };
+}
+
+std::any Message::adopt(){
+  if(hasCode){
+    Adopter adopter{Isolate::current().interpreter.global};
+    adopter.adopt(value);
+    hasCode = false;
+  }
+  return std::move(value);
+}
+
+Channel::Channel(size_t capacity) : queue{capacity} {}
+
+bool Channel::send(Message message){
+  for(int round = 0;; ++round){
+    if(closed.load()) return false;
+    uint32_t seen = received.load();
+    if(queue.push(message)){
+      wake(sent);
+      return true;
+    }
+    if(round < spinRounds){
+      std::this_thread::yield();
+    }else{
+      wait(received, seen);
+    }
+  }
+}
+
+std::any Channel::receive(){
+  Message message;
+  for(int round = 0;; ++round){
+    bool wasClosed = closed.load();
+    uint32_t seen = sent.load();
+    if(queue.pop(message)){
+      wake(received);
+      return message.adopt();
+    }
+    if(wasClosed) return false;
+    if(round < spinRounds){
+      std::this_thread::yield();
+    }else{
+      wait(sent, seen);
+    }
+  }
+}
+
+void Channel::close(){
+  closed = true;
+  wake(sent);
+  wake(received);
+}
+
+size_t Channel::capacity() const {
+  return queue.capacity();
+}
+
+std::string Channel::toString() const {
+  return "<channel>";
+}
+
+// A sleeper registers before waiting and a waker bumps the counter before
+// checking for sleepers, so one of them always sees the other
+void Channel::wait(std::atomic<uint32_t>& counter, uint32_t seen){
+  ++sleepers;
+  counter.wait(seen);
+  --sleepers;
+}
+
+void Channel::wake(std::atomic<uint32_t>& counter){
+  ++counter;
+  if(sleepers.load() != 0){
+    counter.notify_all();
+  }
+}
+
+Bundle::Bundle() : copier{std::make_unique<Copier>()} {}
+Bundle::~Bundle() = default;
+Bundle::Bundle(Bundle&&) noexcept = default;
+Bundle& Bundle::operator=(Bundle&&) noexcept = default;
+
+bool Bundle::add(const std::any& value){
+  size_t before = copier->copied();
+  std::any result;
+  if(!copier->copy(value, result)){
+    copier->rollback(before);
+    return false;
+  }
+  values.push_back(std::move(result));
+  return true;
+}
+
+std::vector<std::any> Bundle::adopt(){
+  if(copier->hasCode){
+    // One adopter for all, so code they share is rebound once
+    Adopter adopter{Isolate::current().interpreter.global};
+    for(std::any& value : values){
+      adopter.adopt(value);
+    }
+  }
+  copier = std::make_unique<Copier>();
+  return std::move(values);
+}
+
+bool Channel::copy(const std::any& value, Message& result){
+  Copier copier;
+  bool copied = copier.copy(value, result.value);
+  result.hasCode = copier.hasCode;
+  return copied;
+}
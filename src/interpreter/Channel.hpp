@@ -0,0 +1,88 @@
+#pragma once
+
+#include <any>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../utils/BoundedQueue.hpp"
+
+class Copier;
+
+/* A value on its way to another isolate, see Channel::copy. Code in it
+   still refers to the sender's globals until the receiver adopts it. */
+struct Message {
+  std::any value;
+  bool hasCode = false;
+
+  // Rebinds functions and classes to the globals of the current isolate
+  std::any adopt();
+};
+
+/* Values on their way to another isolate together, like the arguments and
+   globals of a worker. They share one copier, so objects reachable from
+   several of them are copied once and stay shared on the other side. */
+class Bundle {
+  public:
+    Bundle();
+    ~Bundle();
+    Bundle(Bundle&&) noexcept;
+    Bundle& operator=(Bundle&&) noexcept;
+
+    // Copies value after the others; false, adding nothing, if it cannot
+    // be sent (see Channel::copy)
+    bool add(const std::any& value);
+    // The copies with their code rebound to the current isolate's globals
+    std::vector<std::any> adopt();
+
+    // Copies in the order they were added
+    std::vector<std::any> values;
+
+  private:
+    std::unique_ptr<Copier> copier;
+};
+
+/* Bounded channel between isolates, created by channel(). Values travel in
+   a lock-free queue; send() waits while it is full, which is what slows a
+   fast producer down to the pace of its consumers, and recv() waits while
+   it is empty. A waiting thread spins briefly, then sleeps on a counter
+   the other side bumps, so idle pipelines do not burn CPU. */
+class Channel {
+  public:
+    static constexpr size_t defaultCapacity = 64;
+    // Cells are allocated up front, so channel() refuses anything larger
+    static constexpr size_t maxCapacity = size_t{1} << 24;
+
+    explicit Channel(size_t capacity);
+
+    // False when the channel is closed
+    bool send(Message message);
+    // Next value, or false once the channel is closed and drained: Ter
+    // variables cannot hold nil, so loops test for false
+    std::any receive();
+    void close();
+    size_t capacity() const;
+    std::string toString() const;
+
+    // Copy of a value for another isolate. Strings and frozen values are
+    // immutable and shared; other arrays and instances are copied deeply. Functions and classes declared
+    // inside other functions capture their caller and cannot be sent.
+    static bool copy(const std::any& value, Message& result);
+
+    Channel(const Channel&) = delete;
+    void operator=(const Channel&) = delete;
+
+  private:
+    BoundedQueue<Message> queue;
+    std::atomic<bool> closed{false};
+    // Bumped after every send and receive; waiters sleep on them
+    std::atomic<uint32_t> sent{0};
+    std::atomic<uint32_t> received{0};
+    std::atomic<uint32_t> sleepers{0};
+
+    void wait(std::atomic<uint32_t>& counter, uint32_t seen);
+    void wake(std::atomic<uint32_t>& counter);
+};
@@ -1,15 +1,14 @@
-#include <iostream>
-
 #include "Class.hpp"
 #include "Instance.hpp"
 #include "Interpreter.hpp"
+#include "../utils/Output.hpp"
 
 Class::Class(const std::string& name, std::unordered_map<std::string, std::shared_ptr<Function>> methods) :
   name(name), methods(methods) {}
 
 std::any Class::call(Interpreter &interpreter, std::vector<std::any> arguments){
   if(arguments.size() == 0 && interpreter.global != nullptr){
-    std::cout << "<call from class>\n";
+    Output::get_instance().write("<call from class>\n");
   }
 
   auto instance = std::make_shared<Instance>(std::make_shared<Class>(*this));
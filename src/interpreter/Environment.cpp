@@ -1,22 +1,57 @@
-#include <iostream>
-
 #include "Environment.hpp"
 #include "../utils/RuntimeError.hpp"
+#include "Isolate.hpp"
+#include "HeapProfiler.hpp"
+#include "../utils/Stats.hpp"
+
+Env::Env() : enclosing{nullptr} {
+  ++Stats::get().environments;
+  if(HeapProfiler::active != nullptr) HeapProfiler::active->track(this, HeapProfiler::Kind::Environment);
+}
+
+Env::Env(std::shared_ptr<Env> enclosing ) : enclosing{std::move(enclosing)} {
+  ++Stats::get().environments;
+  if(HeapProfiler::active != nullptr) HeapProfiler::active->track(this, HeapProfiler::Kind::Environment);
+}
 
-Env::Env() : enclosing{nullptr} {}
+Env::~Env(){
+  if(HeapProfiler::active != nullptr) HeapProfiler::active->release(this);
+}
 
-Env::Env(std::shared_ptr<Env> enclosing ) : enclosing{std::move(enclosing)} {}
+size_t Env::size() const {
+  return values.size();
+}
+
+bool Env::isGlobal() const {
+  return enclosing == nullptr;
+}
+
+const std::unordered_map<std::string, std::any>& Env::entries() const {
+  return values;
+}
+
+std::shared_ptr<Env> Env::copy() const {
+  auto env = std::make_shared<Env>();
+  env->values = values;
+  return env;
+}
 
 void Env::define(const std::string& name, std::any value){
   auto elem = values.find(name);
   if(elem != values.end()){
-    std::cerr << "[Error]: the name '" + name + "' for identifier was repeated.\n";
-    std::exit(65);
+    Isolate& isolate = Isolate::current();
+    isolate.output.flush();
+    isolate.errors << "[Error]: the name '" + name + "' for identifier was repeated.\n";
+    throw Isolate::Exit{65};
   }
 
   values[name] = std::move(value);
 }
 
+std::any& Env::slot(const std::string& name){
+  return values.find(name)->second;
+}
+
 std::any Env::get(const Token& name){
   auto elem = values.find(name.lexeme);
   if(elem != values.end()){
@@ -46,7 +81,10 @@ void Env::assign(const Token& name, std::any value){
 }
 
 std::any Env::getAt(int distance, const std::string& name){
-  return anchestor(distance)->values[name];
+  // find() never inserts, so parallel workers can read shared scopes
+  std::shared_ptr<Env> env = anchestor(distance);
+  auto elem = env->values.find(name);
+  return elem != env->values.end() ? elem->second : std::any{};
 }
 
 void Env::assignAt(int distance, Token& name, std::any value){
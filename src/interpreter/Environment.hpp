@@ -5,6 +5,7 @@
 #include <memory>
 
 #include "../tokenizer/Token.hpp"
+#include "../utils/Epoch.hpp"
 
 class Env : public std::enable_shared_from_this<Env> {
   private:
@@ -12,12 +13,24 @@ class Env : public std::enable_shared_from_this<Env> {
     std::unordered_map<std::string, std::any> values;
 
   public:
+    const uint64_t epoch = Epoch::now();
+
     Env();
     Env(std::shared_ptr<Env> enclosing);
+    ~Env();
+    size_t size() const;
     void define(const std::string& name, std::any value);
+    // Where a variable defined here is stored; it stays put until the env
+    // goes, so for-in rebinds its variable without a lookup
+    std::any& slot(const std::string& name);
     std::any get(const Token& name);
     void assign(const Token& name, std::any value);
     std::any getAt(int distance, const std::string& name);
     void assignAt(int distance, Token& name, std::any value);
     std::shared_ptr<Env> anchestor(int distance);
+    // The global environment is the only one without an enclosing one
+    bool isGlobal() const;
+    const std::unordered_map<std::string, std::any>& entries() const;
+    // New global environment with the same variables
+    std::shared_ptr<Env> copy() const;
 };
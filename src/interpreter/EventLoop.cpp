@@ -0,0 +1,399 @@
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <thread>
+
+#include "EventLoop.hpp"
+#include "Builtin.hpp"
+#include "Interpreter.hpp"
+#include "Isolate.hpp"
+#include "Sampler.hpp"
+#include "StringType.hpp"
+
+extern char** environ;
+
+// A child started by exec_async() and the output read from it so far
+struct EventLoop::Process {
+  pid_t pid;
+  int out;
+  std::string output;
+  std::shared_ptr<Promise> promise;
+};
+
+/* Thread for calls that block whatever the file descriptor says: regular
+   files are always "ready" to epoll, and std::cin has a buffer of its own.
+   It is shared with the loop, so a call still blocked when the loop goes
+   away (a read from a terminal) ends on a detached thread. */
+struct EventLoop::Blocking {
+  struct Job {
+    uint64_t id;
+    std::function<bool(std::string&)> work;
+  };
+  struct Done {
+    uint64_t id;
+    bool ok;
+    std::string result;
+  };
+
+  std::mutex lock;
+  std::condition_variable wake;
+  std::deque<Job> jobs;
+  std::vector<Done> done;
+  bool stopping = false;
+  // Written by the thread for every finished job; the loop polls it
+  int signal;
+  uint64_t created = 0;
+  // Promise and builtin of every job, used by the loop only; a failed job
+  // without a builtin resolves to false
+  std::unordered_map<uint64_t, std::pair<std::shared_ptr<Promise>, std::string>> waiting;
+
+  Blocking() : signal{eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)} {}
+
+  ~Blocking(){
+    close(signal);
+  }
+
+  static void work(std::shared_ptr<Blocking> shared){
+    Sampler::ignoreOnThisThread();
+    Blocking& blocking = *shared;
+    std::unique_lock<std::mutex> guard(blocking.lock);
+    for(;;){
+      blocking.wake.wait(guard, [&blocking]{ return blocking.stopping || !blocking.jobs.empty(); });
+      if(blocking.stopping) return;
+      Job job = std::move(blocking.jobs.front());
+      blocking.jobs.pop_front();
+      guard.unlock();
+      std::string result;
+      bool ok = job.work(result);
+      guard.lock();
+      blocking.done.push_back({job.id, ok, std::move(result)});
+      uint64_t one = 1;
+      [[maybe_unused]] ssize_t written = write(blocking.signal, &one, sizeof one);
+    }
+  }
+};
+
+Promise::Promise(EventLoop& owner) : loop{owner}, loopId{owner.id} {}
+
+bool Promise::settled() const {
+  return done;
+}
+
+bool Promise::ownedBy(const EventLoop* owner) const {
+  return owner != nullptr && owner->id == loopId;
+}
+
+std::string Promise::toString() const {
+  return "<promise>";
+}
+
+bool EventLoop::Timer::operator>(const Timer& other) const {
+  if(deadline != other.deadline) return deadline > other.deadline;
+  return sequence > other.sequence;
+}
+
+EventLoop::EventLoop(Interpreter& owner) : interpreter{owner}, poller{epoll_create1(EPOLL_CLOEXEC)} {
+  if(poller < 0) throw std::bad_alloc{};
+}
+
+EventLoop::~EventLoop(){
+  // Fibers still waiting are unwound, see Fiber
+  while(!fibers.empty()){
+    auto fiber = fibers.begin();
+    std::unique_ptr<Fiber> owned = std::move(fiber->second);
+    fibers.erase(fiber);
+  }
+  // Children still running belong to a script that stopped: end them
+  // rather than leave them writing into what runs next
+  for(auto& [fd, process] : processes){
+    close(fd);
+    kill(process->pid, SIGTERM);
+    while(waitpid(process->pid, nullptr, 0) < 0 && errno == EINTR){}
+  }
+  if(blocking != nullptr){
+    std::lock_guard<std::mutex> guard(blocking->lock);
+    blocking->stopping = true;
+    blocking->wake.notify_one();
+  }
+  close(poller);
+}
+
+std::shared_ptr<Promise> EventLoop::start(std::function<std::any()> body){
+  auto promise = std::make_shared<Promise>(*this);
+  auto fiber = std::make_unique<Fiber>([this, promise, body = std::move(body)]{
+    try{
+      resolve(promise, body());
+    }catch(const Fiber::Cancelled&){
+      throw;
+    }catch(const Isolate::Exit&){
+      // A failed builtin stops the isolate, not just this call
+      throw;
+    }catch(...){
+      reject(promise, std::current_exception());
+    }
+  });
+  Fiber* started = fiber.get();
+  fibers.emplace(started, std::move(fiber));
+  resumeFiber(started);
+  return promise;
+}
+
+std::any EventLoop::await(const std::shared_ptr<Promise>& promise){
+  Fiber* fiber = Fiber::current();
+  if(fiber != nullptr && fibers.contains(fiber)){
+    while(!promise->done){
+      promise->waiters.push_back(fiber);
+      // Each side of a switch keeps its own scope
+      std::shared_ptr<Env> env = interpreter.curr_env;
+      Fiber::suspend();
+      interpreter.curr_env = env;
+    }
+  }else{
+    while(!promise->done){
+      if(!step()) builtinError("await");
+    }
+  }
+
+  promise->observed = true;
+  if(!promise->failedBuiltin.empty()) builtinError(promise->failedBuiltin);
+  if(promise->error) std::rethrow_exception(promise->error);
+  return promise->value;
+}
+
+void EventLoop::run(){
+  while(step()){}
+  std::vector<std::shared_ptr<Promise>> failed;
+  failed.swap(unobserved);
+  for(const std::shared_ptr<Promise>& promise : failed){
+    if(!promise->observed) await(promise);
+  }
+}
+
+std::shared_ptr<Promise> EventLoop::sleep(double milliseconds){
+  auto promise = std::make_shared<Promise>(*this);
+  auto delay = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double, std::milli>(milliseconds));
+  timers.push({clock::now() + delay, timersCreated++, promise});
+  return promise;
+}
+
+std::shared_ptr<Promise> EventLoop::exec(const std::string& command){
+  auto promise = std::make_shared<Promise>(*this);
+  int pipe[2];
+  if(pipe2(pipe, O_CLOEXEC) != 0){
+    fail(promise, "exec_async");
+    return promise;
+  }
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, pipe[1], STDOUT_FILENO);
+  std::string shell = "sh";
+  std::string flag = "-c";
+  std::string script = command;
+  char* argv[] = {shell.data(), flag.data(), script.data(), nullptr};
+  pid_t pid;
+  int status = posix_spawn(&pid, "/bin/sh", &actions, nullptr, argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  close(pipe[1]);
+
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = pipe[0];
+  if(status != 0 || fcntl(pipe[0], F_SETFL, O_NONBLOCK) != 0 ||
+      epoll_ctl(poller, EPOLL_CTL_ADD, pipe[0], &event) != 0){
+    close(pipe[0]);
+    if(status == 0) waitpid(pid, nullptr, 0);
+    fail(promise, "exec_async");
+    return promise;
+  }
+  processes.emplace(pipe[0], std::make_unique<Process>(Process{pid, pipe[0], {}, promise}));
+  return promise;
+}
+
+std::shared_ptr<Promise> EventLoop::readFile(const std::string& path){
+  return offload("read_async", [path](std::string& result){
+    std::ifstream file{path, std::ios::binary};
+    if(!file) return false;
+    result.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !file.bad();
+  });
+}
+
+std::shared_ptr<Promise> EventLoop::writeFile(const std::string& path, const std::string& text){
+  return offload("write_async", [path, text](std::string&){
+    std::ofstream file{path, std::ios::binary};
+    file << text;
+    file.close();
+    return !file.fail();
+  });
+}
+
+std::shared_ptr<Promise> EventLoop::readLine(){
+  // The end of input resolves to false, like recv() on a closed channel
+  return offload("", [](std::string& result){
+    return static_cast<bool>(std::getline(std::cin, result));
+  });
+}
+
+void EventLoop::resolve(const std::shared_ptr<Promise>& promise, std::any value){
+  promise->done = true;
+  promise->value = std::move(value);
+  wake(*promise);
+}
+
+void EventLoop::reject(const std::shared_ptr<Promise>& promise, std::exception_ptr error){
+  promise->done = true;
+  promise->error = std::move(error);
+  unobserved.push_back(promise);
+  wake(*promise);
+}
+
+void EventLoop::fail(const std::shared_ptr<Promise>& promise, std::string builtin){
+  promise->done = true;
+  promise->failedBuiltin = std::move(builtin);
+  unobserved.push_back(promise);
+  wake(*promise);
+}
+
+void EventLoop::wake(Promise& promise){
+  ready.insert(ready.end(), promise.waiters.begin(), promise.waiters.end());
+  promise.waiters.clear();
+}
+
+void EventLoop::resumeFiber(Fiber* fiber){
+  std::shared_ptr<Env> env = interpreter.curr_env;
+  fiber->resume();
+  interpreter.curr_env = env;
+  if(fiber->finished()) fibers.erase(fiber);
+}
+
+bool EventLoop::step(){
+  fireTimers();
+  if(!ready.empty()){
+    // Fibers woken meanwhile wait for the next round
+    std::deque<Fiber*> round;
+    round.swap(ready);
+    for(Fiber* fiber : round){
+      resumeFiber(fiber);
+    }
+    return true;
+  }
+  if(timers.empty() && processes.empty() && blockingPending == 0) return false;
+
+  int timeout = -1;
+  if(!timers.empty()){
+    auto wait = std::chrono::ceil<std::chrono::milliseconds>(timers.top().deadline - clock::now());
+    // Wakes up early for delays beyond what epoll takes; the timer is checked again then
+    timeout = static_cast<int>(std::clamp<std::chrono::milliseconds::rep>(wait.count(), 0,
+      std::numeric_limits<int>::max()));
+  }
+  epoll_event events[64];
+  int count = epoll_wait(poller, events, 64, timeout);
+  for(int i = 0; i < count; ++i){
+    int fd = events[i].data.fd;
+    if(blocking != nullptr && fd == blocking->signal){
+      finishBlocking();
+      continue;
+    }
+    auto process = processes.find(fd);
+    if(process != processes.end()){
+      readProcess(*process->second);
+    }
+  }
+  return true;
+}
+
+void EventLoop::fireTimers(){
+  clock::time_point now = clock::now();
+  while(!timers.empty() && timers.top().deadline <= now){
+    std::shared_ptr<Promise> promise = timers.top().promise;
+    timers.pop();
+    resolve(promise, nullptr);
+  }
+}
+
+void EventLoop::readProcess(Process& process){
+  char buffer[1 << 16];
+  for(;;){
+    ssize_t count = read(process.out, buffer, sizeof buffer);
+    if(count > 0){
+      process.output.append(buffer, static_cast<size_t>(count));
+      continue;
+    }
+    if(count < 0 && errno == EINTR) continue;
+    if(count < 0) return;
+    break;
+  }
+
+  // End of output: the child is exiting, so waiting for it is brief
+  std::unique_ptr<Process> finished = std::move(processes[process.out]);
+  processes.erase(finished->out);
+  epoll_ctl(poller, EPOLL_CTL_DEL, finished->out, nullptr);
+  close(finished->out);
+  int status = 0;
+  while(waitpid(finished->pid, &status, 0) < 0 && errno == EINTR){}
+  if(WIFEXITED(status) && WEXITSTATUS(status) == 0){
+    resolve(finished->promise, std::make_shared<StringType>(std::move(finished->output)));
+  }else{
+    fail(finished->promise, "exec_async");
+  }
+}
+
+void EventLoop::finishBlocking(){
+  uint64_t count;
+  [[maybe_unused]] ssize_t drained = read(blocking->signal, &count, sizeof count);
+  std::vector<Blocking::Done> done;
+  {
+    std::lock_guard<std::mutex> guard(blocking->lock);
+    done.swap(blocking->done);
+  }
+  for(Blocking::Done& job : done){
+    auto waiting = blocking->waiting.find(job.id);
+    auto [promise, builtin] = std::move(waiting->second);
+    blocking->waiting.erase(waiting);
+    --blockingPending;
+    if(job.ok){
+      resolve(promise, std::make_shared<StringType>(std::move(job.result)));
+    }else if(builtin.empty()){
+      resolve(promise, false);
+    }else{
+      fail(promise, builtin);
+    }
+  }
+}
+
+std::shared_ptr<Promise> EventLoop::offload(std::string builtin, std::function<bool(std::string&)> job){
+  if(blocking == nullptr){
+    blocking = std::make_shared<Blocking>();
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = blocking->signal;
+    epoll_ctl(poller, EPOLL_CTL_ADD, blocking->signal, &event);
+    std::thread(Blocking::work, blocking).detach();
+  }
+  auto promise = std::make_shared<Promise>(*this);
+  uint64_t id = blocking->created++;
+  blocking->waiting.emplace(id, std::make_pair(promise, std::move(builtin)));
+  ++blockingPending;
+  {
+    std::lock_guard<std::mutex> guard(blocking->lock);
+    blocking->jobs.push_back({id, std::move(job)});
+  }
+  blocking->wake.notify_one();
+  return promise;
+}
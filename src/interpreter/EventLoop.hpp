@@ -0,0 +1,123 @@
+#pragma once
+
+#include <any>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../utils/Fiber.hpp"
+
+class EventLoop;
+class Interpreter;
+
+/* Eventual result of an async function or an I/O builtin, see EventLoop.
+   Settles once, with a value or with an error that await() raises. */
+class Promise {
+  public:
+    explicit Promise(EventLoop& loop);
+
+    bool settled() const;
+    // Whether loop created it; like futures, promises may outlive their loop
+    bool ownedBy(const EventLoop* loop) const;
+    std::string toString() const;
+
+  private:
+    friend class EventLoop;
+
+    EventLoop& loop;
+    const uint64_t loopId;
+    bool done = false;
+    std::any value;
+    std::exception_ptr error;
+    // Set instead of error when a builtin failed: reported when awaited
+    std::string failedBuiltin;
+    bool observed = false;
+    std::vector<Fiber*> waiters;
+};
+
+/* Event loop of one isolate, for async functions and non-blocking I/O.
+   Calling an async function runs it on a fiber of its own up to its first
+   await() of something unfinished, then hands the caller a promise. While
+   fibers wait, the loop sleeps in epoll for subprocess output, timers and
+   file reads done by a helper thread, and resumes the fibers whose
+   promises settled. All of it runs on the isolate's thread, one fiber at
+   a time, so async code needs no locks.
+
+   await() in code that is not async drives the loop until the promise
+   settles; a script runs the loop to the end before it finishes. */
+class EventLoop {
+  public:
+    explicit EventLoop(Interpreter& interpreter);
+    ~EventLoop();
+
+    // Never reused, unlike the address, see Promise::ownedBy
+    const uint64_t id = ++created;
+
+    // Runs body on a new fiber until it first waits
+    std::shared_ptr<Promise> start(std::function<std::any()> body);
+    // Value of a settled promise; waits for it first. Raises its error
+    std::any await(const std::shared_ptr<Promise>& promise);
+    // Runs until nothing is left to wait for, then raises the first error
+    // no one awaited
+    void run();
+
+    // Longest delay sleep() takes: a year, far from overflowing the clock
+    static constexpr double maxSleep = 365.0 * 24 * 60 * 60 * 1000;
+    std::shared_ptr<Promise> sleep(double milliseconds);
+    // Output of `sh -c command`; fails on a non-zero exit status
+    std::shared_ptr<Promise> exec(const std::string& command);
+    std::shared_ptr<Promise> readFile(const std::string& path);
+    std::shared_ptr<Promise> writeFile(const std::string& path, const std::string& text);
+    std::shared_ptr<Promise> readLine();
+
+    EventLoop(const EventLoop&) = delete;
+    void operator=(const EventLoop&) = delete;
+
+  private:
+    inline static std::atomic<uint64_t> created{0};
+    using clock = std::chrono::steady_clock;
+
+    struct Timer {
+      clock::time_point deadline;
+      uint64_t sequence;
+      std::shared_ptr<Promise> promise;
+
+      bool operator>(const Timer& other) const;
+    };
+
+    struct Process;
+    struct Blocking;
+
+    Interpreter& interpreter;
+    int poller;
+    std::unordered_map<Fiber*, std::unique_ptr<Fiber>> fibers;
+    std::deque<Fiber*> ready;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    uint64_t timersCreated = 0;
+    std::unordered_map<int, std::unique_ptr<Process>> processes;
+    std::shared_ptr<Blocking> blocking;
+    size_t blockingPending = 0;
+    std::vector<std::shared_ptr<Promise>> unobserved;
+
+    void resolve(const std::shared_ptr<Promise>& promise, std::any value);
+    void reject(const std::shared_ptr<Promise>& promise, std::exception_ptr error);
+    void fail(const std::shared_ptr<Promise>& promise, std::string builtin);
+    void wake(Promise& promise);
+    void resumeFiber(Fiber* fiber);
+    // One round: runs ready fibers, then waits for and handles events.
+    // False when there is nothing left to wait for
+    bool step();
+    void fireTimers();
+    void readProcess(Process& process);
+    void finishBlocking();
+    // Runs job on the blocking thread; it fails with builtin's error
+    std::shared_ptr<Promise> offload(std::string builtin, std::function<bool(std::string&)> job);
+};
@@ -1,5 +1,7 @@
 #include "Function.hpp"
 #include "Interpreter.hpp"
+#include "Isolate.hpp"
+#include "Generator.hpp"
 
 Function::Function(std::shared_ptr<Statement::Function> declaration,
     std::shared_ptr<Env> closure) : declaration{std::move(declaration)},
@@ -16,6 +18,27 @@ std::any Function::call(Interpreter &interpreter, std::vector<std::any> argument
     newEnv->define(declaration->params[static_cast<size_t>(i)].lexeme, arguments[static_cast<size_t>(i)]);
   }
 
+  if(declaration->isGenerator){
+    return std::make_shared<Generator>(Isolate::current(), [&interpreter, body = declaration->body, newEnv]{
+      try {
+        interpreter.executeBlock(body, newEnv);
+      } catch (const Return&) {
+        // A return only ends the sequence
+      }
+    });
+  }
+
+  if(declaration->isAsync){
+    return Isolate::current().eventLoop().start([&interpreter, body = declaration->body, newEnv]() -> std::any {
+      try {
+        interpreter.executeBlock(body, newEnv);
+      } catch (Return returnObject) {
+        return returnObject.value;
+      }
+      return nullptr;
+    });
+  }
+
   try {
     interpreter.executeBlock(declaration->body, newEnv);
   } catch (Return returnObject) {
@@ -24,6 +47,14 @@ std::any Function::call(Interpreter &interpreter, std::vector<std::any> argument
   return nullptr;
 }
 
+const std::shared_ptr<Statement::Function>& Function::getDeclaration(){
+  return declaration;
+}
+
+std::shared_ptr<Env> Function::getClosure(){
+  return closure.lock();
+}
+
 std::string Function::toString(){
   return "<function " + declaration->name.lexeme + ">";
 }
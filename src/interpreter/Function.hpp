@@ -20,4 +20,6 @@ class Function: public Callable {
     int arity();
     std::any call(Interpreter &interpreter, std::vector<std::any> arguments);
     std::string toString();
+    const std::shared_ptr<Statement::Function>& getDeclaration();
+    std::shared_ptr<Env> getClosure();
 };
@@ -0,0 +1,90 @@
+#include "Future.hpp"
+#include "Channel.hpp"
+#include "Isolate.hpp"
+#include "../utils/Epoch.hpp"
+#include "../utils/ThreadPool.hpp"
+
+Future::Future(Isolate& owner) : spawner{owner}, spawnerId{owner.id} {}
+
+std::shared_ptr<Future> Future::spawn(const std::any& function, const std::vector<std::any>& arguments){
+  Isolate& isolate = Isolate::current();
+  Interpreter& interpreter = isolate.interpreter;
+  // Copies are made after the epoch starts, so the task may modify them
+  uint64_t epoch = Epoch::next();
+  // One bundle, so arguments that share objects still share the copies
+  Bundle bundle;
+  for(const std::any& argument : arguments){
+    if(!bundle.add(argument)) return nullptr;
+  }
+  std::vector<std::any> copies = std::move(bundle.values);
+
+  auto future = std::make_shared<Future>(isolate);
+  isolate.tasks.push_back(future);
+  // Parallel workers and tasks cannot write their globals anyway
+  if(interpreter.sharedEpoch == 0) interpreter.globalsLent = true;
+  ThreadPool::get_instance().submit(
+    [future, epoch, globals = interpreter.global, function, copies = std::move(copies)]() mutable {
+      future->run(epoch, std::move(globals), function, std::move(copies));
+    });
+  return future;
+}
+
+void Future::run(uint64_t epoch, std::shared_ptr<Env> globals, const std::any& function,
+    std::vector<std::any> arguments){
+  {
+    Isolate isolate{spawner, std::move(globals), epoch, &out, errors};
+    isolate.interpreter.inTask = true;
+    Isolate::Scope scope{isolate};
+    try{
+      result = isolate.interpreter.call(function, std::move(arguments));
+      isolate.settle();
+    }catch(...){
+      error = std::current_exception();
+    }
+  }
+  finished.store(true, std::memory_order_release);
+  ThreadPool::get_instance().notifyWaiters();
+}
+
+bool Future::ownedBy(const Isolate& isolate) const {
+  return isolate.id == spawnerId;
+}
+
+bool Future::done() const {
+  return finished.load(std::memory_order_acquire);
+}
+
+std::any Future::join(){
+  std::vector<std::shared_ptr<Future>>& tasks = spawner.tasks;
+  // Usually the latest spawn, so look from the back
+  for(auto task = tasks.rbegin(); task != tasks.rend(); ++task){
+    if(task->get() == this){
+      tasks.erase(std::next(task).base());
+      break;
+    }
+  }
+  if(tasks.empty()) spawner.interpreter.globalsLent = false;
+  return finish();
+}
+
+std::any Future::finish(){
+  if(!done()){
+    ThreadPool::get_instance().helpUntil([this]{ return done(); });
+  }
+  if(!out.empty()){
+    spawner.output.write(out);
+    out.clear();
+  }
+  std::string text = errors.str();
+  if(!text.empty()){
+    spawner.output.flush();
+    spawner.errors << text;
+    errors.str("");
+  }
+  if(error) std::rethrow_exception(error);
+  return result;
+}
+
+std::string Future::toString() const {
+  return "<future>";
+}
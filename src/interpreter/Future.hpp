@@ -0,0 +1,62 @@
+#pragma once
+
+#include <any>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+class Env;
+class Isolate;
+
+/* A function call started by spawn(), running as a task on the ThreadPool
+   while its spawner goes on. The task gets an isolate of its own that
+   reads the spawner's globals, as they were when it was spawned, and
+   copies of its arguments made like channel messages, so the two never
+   write the same data: the task may not modify the globals, and reads
+   only immutable values from them.
+
+   Only the spawner joins its futures, and that is where the task's output
+   and error surface: what it printed is written then, and an error it
+   stopped on is raised in the joiner. A joiner waiting for a task runs
+   other queued tasks meanwhile, so recursive spawns keep every thread
+   busy. Tasks never joined are joined when their spawner's script, call
+   or task ends. */
+class Future {
+  public:
+    explicit Future(Isolate& spawner);
+
+    // Starts function(arguments...) from the current isolate; null if an
+    // argument cannot be copied, see Channel::copy
+    static std::shared_ptr<Future> spawn(const std::any& function, const std::vector<std::any>& arguments);
+
+    // Whether isolate spawned it; a future may outlive its spawner, in the
+    // result of a task, and is then joined by no one
+    bool ownedBy(const Isolate& isolate) const;
+    bool done() const;
+    // Waits for the task and returns its result, see above
+    std::any join();
+    std::string toString() const;
+
+    Future(const Future&) = delete;
+    void operator=(const Future&) = delete;
+
+  private:
+    friend class Isolate;
+
+    Isolate& spawner;
+    const uint64_t spawnerId;
+    std::atomic<bool> finished{false};
+    std::any result;
+    std::exception_ptr error;
+    std::string out;
+    std::ostringstream errors;
+
+    void run(uint64_t epoch, std::shared_ptr<Env> globals, const std::any& function,
+      std::vector<std::any> arguments);
+    // join() for a task already removed from the spawner's list
+    std::any finish();
+};
@@ -0,0 +1,76 @@
+#include "Generator.hpp"
+#include "Isolate.hpp"
+
+Generator::Generator(Isolate& isolate, std::function<void()> body) :
+  owner{&isolate}, fiber{std::make_unique<Fiber>(std::move(body))} {
+  isolate.generators.insert(this);
+}
+
+Generator::~Generator(){
+  if(owner == nullptr) return;
+  close();
+  owner->generators.erase(this);
+}
+
+bool Generator::next(){
+  if(fiber == nullptr) return false;
+  Interpreter& interpreter = owner->interpreter;
+  std::shared_ptr<Env> env = interpreter.curr_env;
+  Generator* previous = resumed;
+  resumed = this;
+  running = true;
+  try{
+    fiber->resume();
+  }catch(...){
+    // An error ends the body like a return
+    resumed = previous;
+    running = false;
+    interpreter.curr_env = env;
+    fiber.reset();
+    throw;
+  }
+  resumed = previous;
+  running = false;
+  interpreter.curr_env = env;
+  if(!fiber->finished()) return true;
+  fiber.reset();
+  current.reset();
+  return false;
+}
+
+const std::any& Generator::value() const {
+  return current;
+}
+
+bool Generator::resumable() const {
+  return !running && owner == &Isolate::current();
+}
+
+std::string Generator::toString() const {
+  return "<generator>";
+}
+
+void Generator::yield(std::any value){
+  Generator* generator = resumed;
+  generator->current = std::move(value);
+  // Each side of the switch keeps its own scope
+  Interpreter& interpreter = generator->owner->interpreter;
+  std::shared_ptr<Env> env = interpreter.curr_env;
+  Fiber::suspend();
+  interpreter.curr_env = env;
+}
+
+void Generator::release(){
+  close();
+  owner = nullptr;
+}
+
+void Generator::close(){
+  if(fiber == nullptr) return;
+  Interpreter& interpreter = owner->interpreter;
+  std::shared_ptr<Env> env = interpreter.curr_env;
+  // Makes the pending yield throw, see Fiber
+  fiber.reset();
+  interpreter.curr_env = env;
+  current.reset();
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <any>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "../utils/Fiber.hpp"
+
+class Isolate;
+
+/* What calling a function that contains `yield` returns. The body runs on
+   a fiber of its own, one step at a time: next() runs it up to its next
+   yield and keeps the yielded value, so a loop over a generator holds one
+   value at a time however long the sequence is. Between steps the body's
+   variables stay where they are; nothing is copied.
+
+   A generator runs only in the isolate that created it, which unwinds the
+   ones still suspended before it goes away. */
+class Generator {
+  public:
+    Generator(Isolate& isolate, std::function<void()> body);
+    ~Generator();
+
+    // Runs the body up to its next yield; false once it has returned.
+    // Only when resumable()
+    bool next();
+    // Value of the last yield
+    const std::any& value() const;
+    // False while the body runs, and outside the isolate that created it
+    bool resumable() const;
+    std::string toString() const;
+
+    // Hands value to the next() that runs the current generator and waits
+    // for the following one
+    static void yield(std::any value);
+    // Unwinds a suspended body and forgets the isolate, which is going away
+    void release();
+
+    Generator(const Generator&) = delete;
+    void operator=(const Generator&) = delete;
+
+  private:
+    Isolate* owner;
+    std::unique_ptr<Fiber> fiber;
+    std::any current;
+    bool running = false;
+
+    // Innermost generator whose body is running on this thread
+    inline static thread_local Generator* resumed = nullptr;
+
+    void close();
+};
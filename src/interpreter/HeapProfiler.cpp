@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+
+#include "HeapProfiler.hpp"
+#include "ArrayType.hpp"
+#include "Environment.hpp"
+#include "Instance.hpp"
+#include "StringType.hpp"
+
+namespace {
+  const char* kindName(HeapProfiler::Kind kind){
+    switch(kind){
+      case HeapProfiler::Kind::Array: return "array";
+      case HeapProfiler::Kind::Instance: return "instance";
+      case HeapProfiler::Kind::String: return "string";
+      case HeapProfiler::Kind::Environment: return "environment";
+    }
+    return "";
+  }
+
+  // Rough size of a hash map node holding a name and a value
+  constexpr size_t entryBytes = sizeof(std::string) + sizeof(std::any) + 2 * sizeof(void*);
+
+  uint64_t estimate(const void* object, HeapProfiler::Kind kind){
+    switch(kind){
+      case HeapProfiler::Kind::Array: {
+        auto array = static_cast<const ArrayType*>(object);
+        return sizeof(ArrayType) + array->values.capacity() * sizeof(std::any)
+          + array->numbers.capacity() * sizeof(double);
+      }
+      case HeapProfiler::Kind::Instance:
+        return sizeof(Instance) + static_cast<const Instance*>(object)->fields.size() * entryBytes;
+      case HeapProfiler::Kind::String:
+        return sizeof(StringType) + static_cast<const StringType*>(object)->length();
+      case HeapProfiler::Kind::Environment:
+        return sizeof(Env) + static_cast<const Env*>(object)->size() * entryBytes;
+    }
+    return 0;
+  }
+}
+
+HeapProfiler::~HeapProfiler(){
+  // Objects outliving the profiler must not report to it
+  if(active == this) active = nullptr;
+}
+
+void HeapProfiler::track(const void* object, Kind kind, const std::string& type){
+  std::string label = type.empty() ? kindName(kind) : std::string{kindName(kind)} + " " + type;
+
+  std::lock_guard<std::mutex> guard(lock);
+  auto key = std::make_tuple(label, current.file, current.line);
+  auto it = index.find(key);
+  if(it == index.end()){
+    Group group;
+    group.type = label;
+    if(current.line == 0){
+      group.site = "<no statement>";
+    }else{
+      group.site = (current.file != nullptr ? *current.file : "") + ":" + std::to_string(current.line);
+    }
+    groups.push_back(std::move(group));
+    it = index.emplace(key, groups.size() - 1).first;
+  }
+
+  ++groups[it->second].allocated;
+  ++groups[it->second].live;
+  objects[object] = {kind, it->second};
+}
+
+void HeapProfiler::release(const void* object){
+  std::lock_guard<std::mutex> guard(lock);
+  auto it = objects.find(object);
+  // Objects created before the profiler was attached are not tracked
+  if(it == objects.end()) return;
+  --groups[it->second.group].live;
+  objects.erase(it);
+}
+
+std::vector<HeapProfiler::Group> HeapProfiler::summary(){
+  std::lock_guard<std::mutex> guard(lock);
+  std::vector<Group> result = groups;
+  for(Group& group : result) group.bytes = 0;
+  for(const auto& [object, info] : objects){
+    result[info.group].bytes += estimate(object, info.kind);
+  }
+  std::sort(result.begin(), result.end(), [](const Group& a, const Group& b){
+    return a.bytes != b.bytes ? a.bytes > b.bytes : a.allocated > b.allocated;
+  });
+  return result;
+}
+
+void HeapProfiler::report(std::ostream& out){
+  std::vector<Group> result = summary();
+
+  uint64_t live = 0, bytes = 0;
+  for(const Group& group : result){
+    live += group.live;
+    bytes += group.bytes;
+  }
+
+  out << "\nHeap profile: " << live << " live objects, ~" << bytes << " bytes\n";
+  out << std::left << std::setw(24) << "type"
+    << std::setw(24) << "allocated at"
+    << std::right << std::setw(12) << "live"
+    << std::setw(14) << "live bytes"
+    << std::setw(14) << "allocated" << '\n';
+  for(const Group& group : result){
+    if(group.live == 0 && group.allocated == 0) continue;
+    out << std::left << std::setw(24) << group.type
+      << std::setw(24) << group.site
+      << std::right << std::setw(12) << group.live
+      << std::setw(14) << group.bytes
+      << std::setw(14) << group.allocated << '\n';
+  }
+}
+
+bool HeapProfiler::snapshot(const std::string& path){
+  std::ofstream file(path);
+  if(!file) return false;
+  report(file);
+  return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+/* Heap profiler enabled with `ter --heap-profile`. Ter objects register
+   themselves on construction and leave on destruction while a profiler is
+   active, so the live set can be broken down by type (instances by class)
+   and by the source line that allocated them. Sizes are estimated when a
+   summary is taken, since arrays and strings grow after allocation. */
+class HeapProfiler {
+  public:
+    enum class Kind { Array, Instance, String, Environment };
+
+    // Profiler of the isolate running on this thread, if any
+    inline static thread_local HeapProfiler* active = nullptr;
+
+    // Statement being executed on this thread, set by the interpreter
+    struct Site {
+      const std::string* file;
+      int line;
+    };
+    inline static thread_local Site current{nullptr, 0};
+
+    ~HeapProfiler();
+
+    void track(const void* object, Kind kind, const std::string& type = "");
+    void release(const void* object);
+
+    void report(std::ostream& out);
+    bool snapshot(const std::string& path);
+
+  private:
+    struct Group {
+      std::string type;
+      std::string site;
+      uint64_t allocated = 0;
+      uint64_t live = 0;
+      uint64_t bytes = 0;
+    };
+
+    struct Object {
+      Kind kind;
+      size_t group;
+    };
+
+    std::mutex lock;
+    std::unordered_map<const void*, Object> objects;
+    std::vector<Group> groups;
+    std::map<std::tuple<std::string, const std::string*, int>, size_t> index;
+
+    std::vector<Group> summary();
+};
@@ -1,18 +1,29 @@
-#include <iostream>
-
 #include "Instance.hpp"
 #include "../utils/RuntimeError.hpp"
 #include "Class.hpp"
+#include "../utils/Output.hpp"
+#include "HeapProfiler.hpp"
+#include "../utils/Stats.hpp"
+
+Instance::Instance(std::shared_ptr<Class> klass) : klass{std::move(klass)} {
+  ++Stats::get().instances;
+  if(HeapProfiler::active != nullptr){
+    HeapProfiler::active->track(this, HeapProfiler::Kind::Instance, this->klass->name);
+  }
+}
 
-Instance::Instance(std::shared_ptr<Class> klass) : klass{std::move(klass)} {}
+Instance::~Instance(){
+  if(HeapProfiler::active != nullptr) HeapProfiler::active->release(this);
+}
 
 std::string Instance::toString(){
   return "<" + klass->name + " class instance>";
 }
 
 std::any Instance::get(const Token& name){
-  if(fields.find(name.lexeme) != fields.end()){
-    return fields[name.lexeme];
+  auto field = fields.find(name.lexeme);
+  if(field != fields.end()){
+    return field->second;
   }
 
   auto method = klass->findMethod(name.lexeme);
@@ -33,7 +44,7 @@ int Instance::arity(){
 
 std::any Instance::call(Interpreter &interpreter, std::vector<std::any> arguments){
   if(arguments.size() == 0 && interpreter.global != nullptr){
-    std::cout << "<call from class instance>\n";
+    Output::get_instance().write("<call from class instance>\n");
   }
   return {};
 }
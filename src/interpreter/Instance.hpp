@@ -2,6 +2,8 @@
 
 #include "Callable.hpp"
 #include "Interpreter.hpp"
+#include "../utils/Epoch.hpp"
+#include <atomic>
 #include <memory>
 #include <unordered_map>
 
@@ -10,7 +12,12 @@ class Class;
 class Instance : public Callable {
   public:
     Instance(std::shared_ptr<Class> klass);
+    ~Instance();
 
+    const uint64_t epoch = Epoch::now();
+    // Set by freeze() with release; readers on other threads load it with
+    // acquire before touching the fields
+    std::atomic<bool> frozen{false};
     std::shared_ptr<Class> klass;
     std::unordered_map<std::string, std::any> fields;
 
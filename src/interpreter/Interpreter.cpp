@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
@@ -10,7 +11,16 @@
 #include "Class.hpp"
 #include "Instance.hpp"
 #include "ArrayType.hpp"  
+#include "StringType.hpp"
+#include "Channel.hpp"
+#include "Future.hpp"
+#include "EventLoop.hpp"
+#include "Generator.hpp"
+#include "Range.hpp"
+#include "Isolate.hpp"
 #include "../utils/RuntimeError.hpp"
+#include "../utils/Output.hpp"
+#include "../utils/Stats.hpp"
 
 Interpreter::Interpreter(){}
 
@@ -22,7 +32,9 @@ void Interpreter::lateInitializator()
   for(const auto& [name, type] : builtinNames){
     auto it = builtinFactory.find(type);
     if(it != builtinFactory.end()){
-      global->define(name, it->second());
+      std::shared_ptr<Callable> builtin = it->second();
+      builtinLabels[builtin.get()] = name;
+      global->define(name, builtin);
     }
   }
 }
@@ -41,7 +53,7 @@ std::any Interpreter::visitUnaryExpr(std::shared_ptr<Unary> expr){
       checkNumberOperand(expr->oper, right);
       right = std::any_cast<double>(right) + 1;
       if (auto varExpr = std::dynamic_pointer_cast<Variable>(expr->right)) {
-        curr_env->assign(varExpr->name, right);
+        assignVariable(varExpr, varExpr->name, right);
       }
       if (expr->isPostOperator) {
         return std::any_cast<double>(right) - 1;
@@ -52,7 +64,7 @@ std::any Interpreter::visitUnaryExpr(std::shared_ptr<Unary> expr){
       checkNumberOperand(expr->oper, right);
       right = std::any_cast<double>(right) - 1;
       if (auto varExpr = std::dynamic_pointer_cast<Variable>(expr->right)) {
-        curr_env->assign(varExpr->name, right);
+        assignVariable(varExpr, varExpr->name, right);
       }
       if (expr->isPostOperator) {
         return std::any_cast<double>(right) + 1;
@@ -80,6 +92,33 @@ bool Interpreter::isTruthy(const std::any& object){
   return true;
 }
 
+void Interpreter::checkWritable(const Token& name, uint64_t epoch){
+  if(epoch < sharedEpoch){
+    throw RuntimeError{name, "Parallel workers cannot modify data they share."};
+  }
+}
+
+// The spawner of a task keeps running while the task reads globals, and
+// could be changing whatever they hold
+void Interpreter::checkShareable(const Token& name, const std::any& value){
+  if(value.type() == typeid(std::shared_ptr<ArrayType>)){
+    if(std::any_cast<const std::shared_ptr<ArrayType>&>(value)->frozen.load(std::memory_order_acquire)) return;
+  }else if(value.type() == typeid(std::shared_ptr<Instance>)){
+    if(std::any_cast<const std::shared_ptr<Instance>&>(value)->frozen.load(std::memory_order_acquire)) return;
+  }else{
+    return;
+  }
+  throw RuntimeError{name, "Spawned tasks can only read frozen arrays and instances from globals."};
+}
+
+void Interpreter::ownGlobals(){
+  if(!globalsLent) return;
+  bool atTopLevel = curr_env == global;
+  global = global->copy();
+  if(atTopLevel) curr_env = global;
+  globalsLent = false;
+}
+
 void Interpreter::checkNumberOperand(const Token& oper, const std::any& operand){
   if(operand.type() == typeid(double)) return;
   throw RuntimeError{oper, "Operand must be a number."};
@@ -118,8 +157,10 @@ bool Interpreter::isEqual(const std::any& a, const std::any& b){
     return std::any_cast<double>(a) == std::any_cast<double>(b);
   }
 
-  if(a.type() == typeid(std::string) && b.type() == typeid(std::string)){
-    return std::any_cast<std::string>(a) == std::any_cast<std::string>(b);
+  if(a.type() == typeid(std::shared_ptr<StringType>) && b.type() == typeid(std::shared_ptr<StringType>)){
+    const auto& left = *std::any_cast<const std::shared_ptr<StringType>&>(a);
+    const auto& right = *std::any_cast<const std::shared_ptr<StringType>&>(b);
+    return left.equals(right);
   }
 
   if(a.type() == typeid(bool) && b.type() == typeid(bool)){
@@ -133,26 +174,12 @@ std::string Interpreter::stringify(const std::any& object){
   if(object.type() == typeid(nullptr)) return "nil";
 
   if(object.type() == typeid(double)){
-    std::string text = std::to_string(std::any_cast<double>(object));
-    if(text[text.length() - 7] == '.' && text[text.length() - 6] == '0'){
-      text = text.substr(0, text.length() - 7);
-    }
-    return text;
+    char buffer[Output::numberBufferSize];
+    return std::string{Output::formatNumber(std::any_cast<double>(object), buffer)};
   }
 
-  if (object.type() == typeid(std::string)) {
-    std::string result = std::any_cast<std::string>(object);
-
-    // Replace the "\n" and "\r" sequences with real newlines and carriage returns
-    size_t pos;
-    while ((pos = result.find("\\n")) != std::string::npos) {
-      result.replace(pos, 2, "\n");
-    }
-    while ((pos = result.find("\\r")) != std::string::npos) {
-      result.replace(pos, 2, "\r");
-    }
-
-    return result;
+  if (object.type() == typeid(std::shared_ptr<StringType>)) {
+    return std::any_cast<const std::shared_ptr<StringType>&>(object)->str();
   }
 
   if(object.type() == typeid(bool)){
@@ -186,11 +213,38 @@ std::string Interpreter::stringify(const std::any& object){
     return klass->toString();
   }
 
+  if(object.type() == typeid(std::shared_ptr<Channel>)){
+    return std::any_cast<const std::shared_ptr<Channel>&>(object)->toString();
+  }
+
+  if(object.type() == typeid(std::shared_ptr<Future>)){
+    return std::any_cast<const std::shared_ptr<Future>&>(object)->toString();
+  }
+  if(object.type() == typeid(std::shared_ptr<Promise>)){
+    return std::any_cast<const std::shared_ptr<Promise>&>(object)->toString();
+  }
+  if(object.type() == typeid(std::shared_ptr<Generator>)){
+    return std::any_cast<const std::shared_ptr<Generator>&>(object)->toString();
+  }
+  if(object.type() == typeid(std::shared_ptr<Range>)){
+    return std::any_cast<const std::shared_ptr<Range>&>(object)->toString();
+  }
+
   if(object.type() == typeid(std::shared_ptr<ArrayType>)){
     std::string result = "[";
-    std::shared_ptr<ArrayType> list;
-    list = std::any_cast<std::shared_ptr<ArrayType>>(object);
-    auto values = list->values;
+    const auto& list = std::any_cast<const std::shared_ptr<ArrayType>&>(object);
+    if(list->isPacked()){
+      char buffer[Output::numberBufferSize];
+      for(size_t i = 0; i < list->numbers.size(); ++i){
+        if(i != 0){
+          result.append(", ");
+        }
+        result.append(Output::formatNumber(list->numbers[i], buffer));
+      }
+      result.append("]");
+      return result;
+    }
+    const auto& values = list->values;
     for (auto i = values.begin(); i != values.end(); ++i) {
       auto next = i + 1;
       result.append(stringify(*i));
@@ -205,6 +259,47 @@ std::string Interpreter::stringify(const std::any& object){
   return "stringify: cannot reconize type";
 }
 
+/* Same text as stringify, written straight to the output buffer so printing
+   numbers, strings and arrays builds no temporary strings. */
+void Interpreter::print(const std::any& object){
+  Output& out = Output::get_instance();
+
+  if(object.type() == typeid(double)){
+    out.writeNumber(std::any_cast<double>(object));
+    return;
+  }
+
+  if(object.type() == typeid(std::shared_ptr<StringType>)){
+    out.write(std::any_cast<const std::shared_ptr<StringType>&>(object)->str());
+    return;
+  }
+
+  if(object.type() == typeid(std::shared_ptr<ArrayType>)){
+    const auto& list = std::any_cast<const std::shared_ptr<ArrayType>&>(object);
+    out.put('[');
+    if(list->isPacked()){
+      for(size_t i = 0; i < list->numbers.size(); ++i){
+        if(i != 0){
+          out.write(", ");
+        }
+        out.writeNumber(list->numbers[i]);
+      }
+      out.put(']');
+      return;
+    }
+    for(size_t i = 0; i < list->values.size(); ++i){
+      if(i != 0){
+        out.write(", ");
+      }
+      print(list->values[i]);
+    }
+    out.put(']');
+    return;
+  }
+
+  out.write(stringify(object));
+}
+
 std::any Interpreter::visitGroupingExpr(std::shared_ptr<Grouping> expr){
   return evaluate(expr->expression);
 }
@@ -248,8 +343,9 @@ std::any Interpreter::visitBinaryExpr(std::shared_ptr<Binary> expr){
         return std::any_cast<double>(left) + std::any_cast<double>(right);
       }
 
-      if(left.type() == typeid(std::string) && right.type() == typeid(std::string)){
-        return std::any_cast<std::string>(left) + std::any_cast<std::string>(right);
+      if(left.type() == typeid(std::shared_ptr<StringType>) && right.type() == typeid(std::shared_ptr<StringType>)){
+        return StringType::concat(std::any_cast<const std::shared_ptr<StringType>&>(left),
+            std::any_cast<const std::shared_ptr<StringType>&>(right));
       }
 
       throw RuntimeError{expr->oper, "Operands not a same type"};
@@ -290,12 +386,31 @@ void Interpreter::interpret(std::vector<std::shared_ptr<Statement::Stmt>> &state
     for(std::shared_ptr<Statement::Stmt> &statement: statements){
       execute(statement);
     }
+    // A script is not done before its async calls and the tasks it spawned
+    Isolate::current().settle();
   }catch(const RuntimeError& e){
     Debug::runtimeError(e);
   }
 }
 
 void Interpreter::execute(std::shared_ptr<Statement::Stmt> statement){
+  if(lineProfiler == nullptr && heapProfiler == nullptr){
+    statement->accept(*this);
+    return;
+  }
+
+  // Allocations are attributed to the innermost running statement
+  struct Site {
+    HeapProfiler::Site previous = HeapProfiler::current;
+    ~Site(){ HeapProfiler::current = previous; }
+  } site;
+  HeapProfiler::current = {statement->file.get(), statement->line};
+
+  if(lineProfiler != nullptr){
+    LineProfiler::Scope scope{*lineProfiler, *statement};
+    statement->accept(*this);
+    return;
+  }
   statement->accept(*this);
 }
 
@@ -306,22 +421,25 @@ std::any Interpreter::visitExpressionStmt(std::shared_ptr<Statement::Expression>
 
 std::any Interpreter::visitPrintStmt(std::shared_ptr<Statement::Print> stmt){
   std::any value = evaluate(stmt->expression);
-  std::cout << stringify(value) << '\n';
+  print(value);
+  Output::get_instance().put('\n');
   return {};
 }
 
 std::any Interpreter::visitOutStmt(std::shared_ptr<Statement::Out> stmt){
   std::any value = evaluate(stmt->expression);
-  std::cout << stringify(value);
+  print(value);
   return {};
 }
 
 std::any Interpreter::visitVariableExpr(std::shared_ptr<Variable> expr){
-  std::any value = curr_env->get(expr->name);
+  // Resolved slots, not a search by name up the closure chain: a function
+  // shared with another isolate must read that isolate's globals
+  std::any value = lookUpVariable(expr->name, expr);
   if(value.type() == typeid(nullptr)){
     throw RuntimeError(expr->name, "Variable not initialized.");
   }
-  return curr_env->get(expr->name);
+  return value;
 }
 
 std::any Interpreter::visitVarStmt(std::shared_ptr<Statement::Var> stmt){
@@ -329,20 +447,28 @@ std::any Interpreter::visitVarStmt(std::shared_ptr<Statement::Var> stmt){
   if(stmt->init != nullptr){
     value = evaluate(stmt->init);
   }
+  if(curr_env == global) ownGlobals();
   curr_env->define(stmt->name.lexeme, std::move(value));
   return {};
 }
 
 std::any Interpreter::visitAssignExpr(std::shared_ptr<Assign> expr){
   std::any value = evaluate(expr->value);
-  auto elem = locals.find(expr);
-  if(elem != locals.end()){
+  assignVariable(expr, expr->name, value);
+  return value;
+}
+
+void Interpreter::assignVariable(const std::shared_ptr<Expr>& expr, Token& name, const std::any& value){
+  auto elem = locals->find(expr);
+  if(elem != locals->end()){
     int distance = elem->second;
-    curr_env->assignAt(distance, expr->name, value);
+    if(sharedEpoch != 0) checkWritable(name, curr_env->anchestor(distance)->epoch);
+    curr_env->assignAt(distance, name, value);
   }else{
-    global->assign(expr->name, value);
+    if(sharedEpoch != 0) checkWritable(name, global->epoch);
+    ownGlobals();
+    global->assign(name, value);
   }
-  return value;
 }
 
 
@@ -404,29 +530,96 @@ std::any Interpreter::visitCallExpr(std::shared_ptr<Call> expr){
     arguments.push_back(evaluate(argument));
   }
 
+  if(!isCallable(callee)){
+    throw RuntimeError{expr->paren, "Can only call functions and classes."};
+  }
+  return call(callee, std::move(arguments));
+}
+
+bool Interpreter::isCallable(const std::any& callee){
+  return callee.type() == typeid(std::shared_ptr<Callable>) ||
+    callee.type() == typeid(std::shared_ptr<Function>) ||
+    callee.type() == typeid(std::shared_ptr<Class>);
+}
+
+std::any Interpreter::call(const std::any& callee, std::vector<std::any> arguments){
+  ++Stats::get().calls;
+  if(profiler != nullptr || sampler != nullptr || tracer != nullptr){
+    return profiledCall(callee, std::move(arguments));
+  }
+
   // Check if it is a generic Callable
   if(callee.type() == typeid(std::shared_ptr<Callable>)){
-    auto function = std::any_cast<std::shared_ptr<Callable>>(callee);
-    return function->call(*this, arguments);
+    const auto& function = std::any_cast<const std::shared_ptr<Callable>&>(callee);
+    return function->call(*this, std::move(arguments));
   }
 
   // Checks if it is a user-defined function
   if(callee.type() == typeid(std::shared_ptr<Function>)){
-    auto function = std::any_cast<std::shared_ptr<Function>>(callee);
-    return function->call(*this, arguments);
+    const auto& function = std::any_cast<const std::shared_ptr<Function>&>(callee);
+    return function->call(*this, std::move(arguments));
   }
 
   // Checks if it is a class (to instantiate objects)
-  if(callee.type() == typeid(std::shared_ptr<Class>)){
+  auto klass = std::any_cast<std::shared_ptr<Class>>(callee);
+  return std::make_shared<Instance>(klass);
+}
+
+std::any Interpreter::profiledCall(const std::any& callee, std::vector<std::any> arguments){
+  const void* key;
+  const std::string* name;
+  std::string unnamed;
+  int line = 0;
+  bool builtin = false;
+
+  if(callee.type() == typeid(std::shared_ptr<Function>)){
+    const auto& declaration = std::any_cast<const std::shared_ptr<Function>&>(callee)->getDeclaration();
+    key = declaration.get();
+    name = &declaration->name.lexeme;
+    line = declaration->name.line;
+  }else if(callee.type() == typeid(std::shared_ptr<Callable>)){
+    const auto& callable = std::any_cast<const std::shared_ptr<Callable>&>(callee);
+    auto label = builtinLabels.find(callable.get());
+    if(label == builtinLabels.end()){
+      unnamed = callable->toString();
+    }
+    key = callable.get();
+    name = label != builtinLabels.end() ? &label->second : &unnamed;
+    builtin = true;
+  }else{
     auto klass = std::any_cast<std::shared_ptr<Class>>(callee);
     return std::make_shared<Instance>(klass);
   }
 
-  throw RuntimeError{expr->paren, "Can only call functions and classes."};
+  struct Scope {
+    Interpreter& interpreter;
+    const std::string& name;
+    int line;
+    Tracer::clock::time_point start;
+    ~Scope(){
+      if(interpreter.profiler != nullptr) interpreter.profiler->leave();
+      if(interpreter.sampler != nullptr) interpreter.sampler->pop();
+      if(interpreter.tracer != nullptr) interpreter.tracer->call(name, line, start);
+    }
+  };
+
+  if(profiler != nullptr){
+    profiler->enter(profiler->entryFor(key, *name, line, builtin));
+  }
+  if(sampler != nullptr){
+    sampler->push(sampler->labelFor(key, *name, line));
+  }
+  Scope scope{*this, *name, line, tracer != nullptr ? Tracer::clock::now() : Tracer::clock::time_point{}};
+
+  if(builtin){
+    return std::any_cast<const std::shared_ptr<Callable>&>(callee)->call(*this, std::move(arguments));
+  }
+  return std::any_cast<const std::shared_ptr<Function>&>(callee)->call(*this, std::move(arguments));
 }
 
 
 std::any Interpreter::visitFunctionStmt(std::shared_ptr<Statement::Function> stmt){
+  if(curr_env == global) ownGlobals();
   auto function = std::make_shared<Function>(stmt, curr_env);
   curr_env->define(stmt->name.lexeme, function);
   return {};
@@ -437,24 +630,100 @@ std::any Interpreter::visitReturnStmt(std::shared_ptr<Statement::Return> stmt){
   if(stmt->value != nullptr){
     value = evaluate(stmt->value);
   }
+  ++Stats::get().exceptions;
   throw Return{value};
 }
 
+std::any Interpreter::visitYieldStmt(std::shared_ptr<Statement::Yield> stmt){
+  Generator::yield(evaluate(stmt->value));
+  return {};
+}
+
+std::any Interpreter::visitForInStmt(std::shared_ptr<Statement::ForIn> stmt){
+  std::any iterable = evaluate(stmt->iterable);
+  auto loopEnv = std::make_shared<Env>(curr_env);
+  loopEnv->define(stmt->name.lexeme, nullptr);
+  std::any& item = loopEnv->slot(stmt->name.lexeme);
+
+  std::shared_ptr<Env> previous = curr_env;
+  try{
+    curr_env = loopEnv;
+    iterate(stmt, iterable, item);
+  }catch(...){
+    curr_env = previous;
+    throw;
+  }
+  curr_env = previous;
+  return {};
+}
+
+void Interpreter::iterate(const std::shared_ptr<Statement::ForIn>& stmt, const std::any& iterable, std::any& item){
+  const std::type_info& type = iterable.type();
+  if(type == typeid(std::shared_ptr<ArrayType>)){
+    const auto& list = std::any_cast<const std::shared_ptr<ArrayType>&>(iterable);
+    // The body may resize or unpack the array, so both are checked each time
+    for(int i = 0; i < list->length(); ++i){
+      if(list->isPacked()){
+        item = list->numbers[static_cast<size_t>(i)];
+      }else{
+        item = list->values[static_cast<size_t>(i)];
+      }
+      execute(stmt->body);
+    }
+  }else if(type == typeid(std::shared_ptr<StringType>)){
+    // Strings never change: their characters are walked in place, a whole
+    // UTF-8 sequence at a time
+    const std::string& text = std::any_cast<const std::shared_ptr<StringType>&>(iterable)->str();
+    for(size_t i = 0; i < text.size();){
+      unsigned char lead = static_cast<unsigned char>(text[i]);
+      size_t width = lead < 0xC0 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+      width = std::min(width, text.size() - i);
+      if(width == 1){
+        item = StringType::character(text[i]);
+      }else{
+        item = std::make_shared<StringType>(text.substr(i, width));
+      }
+      i += width;
+      execute(stmt->body);
+    }
+  }else if(type == typeid(std::shared_ptr<Range>)){
+    const Range& range = *std::any_cast<const std::shared_ptr<Range>&>(iterable);
+    for(int64_t i = 0; i < range.size(); ++i){
+      item = range.at(i);
+      execute(stmt->body);
+    }
+  }else if(type == typeid(std::shared_ptr<Generator>)){
+    Generator& generator = *std::any_cast<const std::shared_ptr<Generator>&>(iterable);
+    for(;;){
+      if(!generator.resumable()){
+        throw RuntimeError{stmt->name, "Can only resume a suspended generator of this isolate."};
+      }
+      if(!generator.next()) break;
+      item = generator.value();
+      execute(stmt->body);
+    }
+  }else{
+    throw RuntimeError{stmt->name, "Can only iterate over arrays, strings, ranges and generators."};
+  }
+}
+
 std::any Interpreter::lookUpVariable(Token& name, std::shared_ptr<Expr> expr){
-  auto elem = locals.find(expr);
-  if(elem != locals.end()){
+  auto elem = locals->find(expr);
+  if(elem != locals->end()){
     int distance = elem->second;
     return curr_env->getAt(distance, name.lexeme);
-  }else{
-    return global->get(name);
   }
+  std::any value = global->get(name);
+  if(inTask) checkShareable(name, value);
+  return value;
 }
 
 void Interpreter::resolve(std::shared_ptr<Expr> expr, int depth){
-  locals[expr] = depth;
+  (*locals)[expr] = depth;
 }
 
 std::any Interpreter::visitClassStmt(std::shared_ptr<Statement::Class> stmt){
+  if(curr_env == global) ownGlobals();
   std::any value = nullptr;
   curr_env->define(stmt->name.lexeme, value);
 
@@ -487,6 +756,8 @@ std::any Interpreter::visitSetExpr(std::shared_ptr<Set> expr){
   }
   std::any value = evaluate(expr->value);
   auto instance = std::any_cast<std::shared_ptr<Instance>>(object);
+  if(instance->frozen.load(std::memory_order_acquire)) throw RuntimeError{expr->name, "Cannot modify a frozen value."};
+  if(sharedEpoch != 0) checkWritable(expr->name, instance->epoch);
   instance->set(expr->name, value);
   return value;
 }
@@ -518,6 +789,8 @@ std::any Interpreter::visitCallistExpr(std::shared_ptr<Callist> expr){
       castedIndex = std::any_cast<double>(index);
       if(expr->value != nullptr){
         std::any value = evaluate(expr->value);
+        if(list->frozen.load(std::memory_order_acquire)) throw RuntimeError{expr->paren, "Cannot modify a frozen value."};
+        if(sharedEpoch != 0) checkWritable(expr->paren, list->epoch);
         if(list->setAtIndex(static_cast<int>(castedIndex), value)) {
           return value; 
         }else{
@@ -5,6 +5,13 @@
 
 #include "Environment.hpp"
 #include "../parser/Stmt.hpp"
+#include "../utils/Random.hpp"
+#include "Profiler.hpp"
+#include "Sampler.hpp"
+#include "LineProfiler.hpp"
+#include "HeapProfiler.hpp"
+#include "../utils/Tracer.hpp"
+#include "Callable.hpp"
 
 struct Return {
   std::any value;
@@ -42,22 +49,61 @@ class Interpreter : public ExprVisitor, public Statement::StmtVisitor {
     std::any visitWhileStmt(std::shared_ptr<Statement::While> stmt) override;
     std::any visitFunctionStmt(std::shared_ptr<Statement::Function> stmt) override;
     std::any visitReturnStmt(std::shared_ptr<Statement::Return> stmt) override;
+    std::any visitYieldStmt(std::shared_ptr<Statement::Yield> stmt) override;
+    std::any visitForInStmt(std::shared_ptr<Statement::ForIn> stmt) override;
     std::any visitClassStmt(std::shared_ptr<Statement::Class> stmt) override;
     std::any visitIncludeStmt(std::shared_ptr<Statement::Include> stmt) override;
 
+    std::string stringify(const std::any& object);
+    bool isCallable(const std::any& callee);
+    // Calls a function, builtin or class held in a value; see isCallable
+    std::any call(const std::any& callee, std::vector<std::any> arguments);
+
     std::shared_ptr<Env> global = std::make_shared<Env>();
+    Random random;
+    // Attached by `ter --profile`, `--sample-profile`, `--line-profile`,
+    // `--heap-profile` and `--trace`; null otherwise
+    std::unique_ptr<Profiler> profiler;
+    std::unique_ptr<Sampler> sampler;
+    std::unique_ptr<LineProfiler> lineProfiler;
+    std::unique_ptr<HeapProfiler> heapProfiler;
+    Tracer* tracer = nullptr;
+    std::unordered_map<const Callable*, std::string> builtinLabels;
+    // Set in parallel workers: objects from an older epoch are read-only
+    uint64_t sharedEpoch = 0;
+    // Set in spawned tasks, whose spawner keeps running: only immutable
+    // globals may be read
+    bool inTask = false;
+    // Set while spawned tasks may read `global`: the next write to a global
+    // goes to a copy instead, see ownGlobals
+    bool globalsLent = false;
+    // Swaps `global` for a copy if tasks read it, before it is written
+    void ownGlobals();
 
   private:
+    friend class Isolate;
+    friend class Worker;
+    friend class EventLoop;
+    friend class Generator;
+
     void checkNumberOperand(const Token& oper, const std::any& operand);
     void checkNumberOperands(const Token& oper, const std::any& left, const std::any& right);
     int64_t doubleToInt(const Token& oper, const std::any& value);
     bool isTruthy(const std::any& object);
     bool isEqual(const std::any& a, const std::any& b);
-    std::string stringify(const std::any& object);
+    void print(const std::any& object);
+    std::any profiledCall(const std::any& callee, std::vector<std::any> arguments);
     std::any evaluate(std::shared_ptr<Expr> expr);
+    // Runs a for-in body once per element, with item bound to it
+    void iterate(const std::shared_ptr<Statement::ForIn>& stmt, const std::any& iterable, std::any& item);
+    void checkWritable(const Token& name, uint64_t epoch);
+    void checkShareable(const Token& name, const std::any& value);
 
-    std::unordered_map<std::shared_ptr<Expr>, int> locals;
+    // Shared with the worker interpreters of parallel builtins
+    std::shared_ptr<std::unordered_map<std::shared_ptr<Expr>, int>> locals =
+      std::make_shared<std::unordered_map<std::shared_ptr<Expr>, int>>();
     std::shared_ptr<Env> curr_env = global;
     std::any lookUpVariable(Token& name, std::shared_ptr<Expr> expr);
+    void assignVariable(const std::shared_ptr<Expr>& expr, Token& name, const std::any& value);
 };
 
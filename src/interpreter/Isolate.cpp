@@ -0,0 +1,88 @@
+#include "Isolate.hpp"
+#include "Worker.hpp"
+#include "Future.hpp"
+#include "Generator.hpp"
+#include "../utils/ThreadPool.hpp"
+#include "../utils/Stats.hpp"
+
+Isolate::Isolate(std::vector<std::string> scriptArgs, std::string* capture, std::ostream& errorStream) :
+  output{capture}, args{std::move(scriptArgs)}, errors{errorStream} {
+  // Builtins are defined once per isolate, not once per script run
+  interpreter.lateInitializator();
+}
+
+Isolate::Isolate(Isolate& parent, uint64_t sharedEpoch, std::string* capture, std::ostream& errorStream) :
+  Isolate{parent, parent.interpreter.global, sharedEpoch, capture, errorStream} {}
+
+Isolate::Isolate(Isolate& parent, std::shared_ptr<Env> globals, uint64_t sharedEpoch,
+    std::string* capture, std::ostream& errorStream) :
+  output{capture}, args{parent.args}, errors{errorStream}, dir{parent.dir} {
+  interpreter.global = std::move(globals);
+  interpreter.curr_env = interpreter.global;
+  interpreter.locals = parent.interpreter.locals;
+  interpreter.sharedEpoch = sharedEpoch;
+  interpreter.inTask = parent.interpreter.inTask;
+}
+
+Isolate::~Isolate(){
+  // Tasks read this isolate's globals; ones never joined are waited for
+  ThreadPool& pool = ThreadPool::get_instance();
+  for(const std::shared_ptr<Future>& task : tasks){
+    pool.helpUntil([&task]{ return task->done(); });
+  }
+  // Workers report into this isolate's output, so they go first
+  workers.clear();
+  // Unwinding one generator can free others, which then leave the set
+  while(!generators.empty()){
+    Generator* generator = *generators.begin();
+    generators.erase(generators.begin());
+    generator->release();
+  }
+}
+
+void Isolate::joinTasks(){
+  std::vector<std::shared_ptr<Future>> pending;
+  pending.swap(tasks);
+  for(size_t i = 0; i < pending.size(); ++i){
+    try{
+      pending[i]->finish();
+    }catch(...){
+      // The rest still run and must be waited for
+      tasks.insert(tasks.end(), pending.begin() + static_cast<std::ptrdiff_t>(i) + 1, pending.end());
+      throw;
+    }
+  }
+  interpreter.globalsLent = false;
+}
+
+EventLoop& Isolate::eventLoop(){
+  if(loop == nullptr) loop = std::make_unique<EventLoop>(interpreter);
+  return *loop;
+}
+
+void Isolate::settle(){
+  if(loop != nullptr) loop->run();
+  joinTasks();
+}
+
+int Isolate::status() const {
+  if(debug.hadError) return 65;
+  if(debug.hadRuntimeError) return 70;
+  return 0;
+}
+
+Isolate& Isolate::current(){
+  if(active != nullptr) return *active;
+  thread_local Isolate fallback;
+  return fallback;
+}
+
+Isolate::Scope::Scope(Isolate& isolate) : previous{active}, previousStats{Stats::active} {
+  active = &isolate;
+  Stats::active = &isolate.stats;
+}
+
+Isolate::Scope::~Scope(){
+  active = previous;
+  Stats::active = previousStats;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "EventLoop.hpp"
+#include "Interpreter.hpp"
+#include "../utils/Debug.hpp"
+#include "../utils/Output.hpp"
+#include "../utils/Stats.hpp"
+
+struct ter_isolate;
+class Future;
+class Generator;
+class Worker;
+
+/* Everything one running script owns: its interpreter and globals, error
+   flags, buffered output, args() and the directory includes are resolved
+   against, and its runtime counters. N of them can run on N threads.
+   Code that used to reach for process-wide singletons finds its isolate
+   through Isolate::current(), set for the thread by a Scope; a thread
+   that never entered one gets a default isolate of its own. Still shared
+   by the whole process: Ter::options, the string intern table, the
+   Tracer, PerfCounters and the running Sampler. */
+class Isolate {
+  public:
+    // Thrown instead of std::exit() so only the failing isolate stops
+    struct Exit {
+      int code;
+    };
+
+    // `capture`, when given, receives stdout; `errorStream` gets error reports
+    explicit Isolate(std::vector<std::string> scriptArgs = {},
+      std::string* capture = nullptr, std::ostream& errorStream = std::cerr);
+    // Worker of a parallel section: shares the parent's globals and resolved
+    // variables, and only writes what it creates after sharedEpoch
+    Isolate(Isolate& parent, uint64_t sharedEpoch, std::string* capture, std::ostream& errorStream);
+    // Same with the given globals, for a task spawned earlier
+    Isolate(Isolate& parent, std::shared_ptr<Env> globals, uint64_t sharedEpoch,
+      std::string* capture, std::ostream& errorStream);
+
+    // Never reused, unlike the address: futures outliving their isolate
+    // compare it, see Future::ownedBy
+    const uint64_t id = ++created;
+    // Declared first so buffered output is flushed after the interpreter goes
+    Output output;
+    Debug debug;
+    Interpreter interpreter;
+    std::vector<std::string> args;
+    std::ostream& errors;
+    // Relative include paths are looked up here; empty for the working directory
+    std::filesystem::path dir;
+    // C API handle, see src/capi; extensions imported with import_native()
+    std::shared_ptr<ter_isolate> handle;
+    std::unordered_set<void*> extensions;
+    // Started by spawn_worker(), joined on destruction; in a script worker,
+    // workerArgs holds the values args() returns
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::any> workerArgs;
+    bool isWorkerScript = false;
+    // Started by spawn() and not joined yet, oldest first
+    std::vector<std::shared_ptr<Future>> tasks;
+    // Created by the first async call or async builtin. Destroyed before
+    // the interpreter, which its fibers are unwound through
+    std::unique_ptr<EventLoop> loop;
+    // Generators created here, unwound on destruction while the
+    // interpreter they run in is still there
+    std::unordered_set<Generator*> generators;
+    // What stats() and `--stats` report, counted while the isolate is current
+    Stats::Counters stats;
+
+    // Exit code of a finished script: 65 compile error, 70 runtime error
+    int status() const;
+    // Joins the remaining tasks in spawn order; raises the first error
+    void joinTasks();
+    EventLoop& eventLoop();
+    // Runs the event loop to the end and joins tasks: what a script or a
+    // call from outside leaves behind must be done when it returns
+    void settle();
+
+    static Isolate& current();
+
+    // Makes an isolate current on this thread for the lifetime of the scope
+    class Scope {
+      public:
+        explicit Scope(Isolate& isolate);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        void operator=(const Scope&) = delete;
+
+      private:
+        Isolate* previous;
+        Stats::Counters* previousStats;
+    };
+
+    ~Isolate();
+    Isolate(const Isolate&) = delete;
+    void operator=(const Isolate&) = delete;
+
+  private:
+    inline static thread_local Isolate* active = nullptr;
+    inline static std::atomic<uint64_t> created{0};
+};
@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+
+#include "LineProfiler.hpp"
+#include "../parser/Stmt.hpp"
+
+namespace {
+  // Collects every statement, including those in bodies that never run
+  struct Collector : Statement::StmtVisitor {
+    std::vector<std::shared_ptr<Statement::Stmt>>& nodes;
+
+    explicit Collector(std::vector<std::shared_ptr<Statement::Stmt>>& nodes) : nodes{nodes} {}
+
+    void collect(const std::shared_ptr<Statement::Stmt>& stmt){
+      if(stmt == nullptr) return;
+      if(stmt->line > 0) nodes.push_back(stmt);
+      stmt->accept(*this);
+    }
+
+    void collect(const std::vector<std::shared_ptr<Statement::Stmt>>& statements){
+      for(const auto& stmt : statements) collect(stmt);
+    }
+
+    std::any visitExpressionStmt(std::shared_ptr<Statement::Expression>) override { return {}; }
+    std::any visitPrintStmt(std::shared_ptr<Statement::Print>) override { return {}; }
+    std::any visitOutStmt(std::shared_ptr<Statement::Out>) override { return {}; }
+    std::any visitVarStmt(std::shared_ptr<Statement::Var>) override { return {}; }
+    std::any visitReturnStmt(std::shared_ptr<Statement::Return>) override { return {}; }
+    std::any visitIncludeStmt(std::shared_ptr<Statement::Include>) override { return {}; }
+    std::any visitYieldStmt(std::shared_ptr<Statement::Yield>) override { return {}; }
+
+    std::any visitBlockStmt(std::shared_ptr<Statement::Block> stmt) override {
+      collect(stmt->statements);
+      return {};
+    }
+
+    std::any visitIfStmt(std::shared_ptr<Statement::If> stmt) override {
+      collect(stmt->thenBranch);
+      collect(stmt->elseBranch);
+      return {};
+    }
+
+    std::any visitWhileStmt(std::shared_ptr<Statement::While> stmt) override {
+      collect(stmt->body);
+      return {};
+    }
+
+    std::any visitForInStmt(std::shared_ptr<Statement::ForIn> stmt) override {
+      collect(stmt->body);
+      return {};
+    }
+
+    std::any visitFunctionStmt(std::shared_ptr<Statement::Function> stmt) override {
+      collect(stmt->body);
+      return {};
+    }
+
+    std::any visitClassStmt(std::shared_ptr<Statement::Class> stmt) override {
+      for(const auto& method : stmt->methods) collect(method->body);
+      return {};
+    }
+  };
+}
+
+LineProfiler::Scope::Scope(LineProfiler& profiler, Statement::Stmt& stmt) :
+  profiler{profiler}, stmt{stmt} {
+  profiler.children.push_back(0);
+  start = clock::now();
+}
+
+LineProfiler::Scope::~Scope(){
+  int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+  int64_t nested = profiler.children.back();
+  profiler.children.pop_back();
+
+  ++stmt.hits;
+  stmt.selfNs += elapsed - nested;
+  if(!profiler.children.empty()){
+    profiler.children.back() += elapsed;
+  }
+}
+
+void LineProfiler::add(const std::vector<std::shared_ptr<Statement::Stmt>>& statements){
+  Collector{nodes}.collect(statements);
+}
+
+void LineProfiler::addSource(const std::string& file, const std::string& source){
+  sources[file] = source;
+}
+
+// A line counts as run as often as its most-run statement; a `for` header
+// holds the init, the condition loop and the increment
+std::map<std::string, std::map<int, LineProfiler::Line>> LineProfiler::lines(){
+  std::map<std::string, std::map<int, Line>> result;
+  for(const auto& node : nodes){
+    Line& line = result[node->file ? *node->file : ""][node->line];
+    line.hits = std::max(line.hits, node->hits);
+    line.selfNs += node->selfNs;
+  }
+  return result;
+}
+
+void LineProfiler::report(std::ostream& out){
+  auto byFile = lines();
+
+  int64_t total = 0;
+  for(const auto& [file, fileLines] : byFile){
+    for(const auto& [number, line] : fileLines) total += line.selfNs;
+  }
+
+  for(const auto& [file, fileLines] : byFile){
+    auto source = sources.find(file);
+    std::string text;
+    if(source != sources.end()){
+      text = source->second;
+    }else{
+      std::ifstream in(file);
+      std::stringstream buffer;
+      buffer << in.rdbuf();
+      text = buffer.str();
+    }
+
+    out << "\nLine profile: " << file << '\n';
+    out << std::right << std::setw(12) << "count"
+      << std::setw(12) << "self ms"
+      << std::setw(8) << "%" << "  line\n";
+
+    std::istringstream stream(text);
+    std::string code;
+    int number = 0;
+    out << std::fixed;
+    while(std::getline(stream, code)){
+      ++number;
+      auto it = fileLines.find(number);
+      if(it == fileLines.end()){
+        out << std::setw(32) << "";
+      }else if(it->second.hits == 0){
+        out << std::setw(12) << "#####" << std::setw(20) << "";
+      }else{
+        double percent = total > 0 ? 100.0 * static_cast<double>(it->second.selfNs) / static_cast<double>(total) : 0.0;
+        out << std::setw(12) << it->second.hits
+          << std::setw(12) << std::setprecision(3) << static_cast<double>(it->second.selfNs) / 1e6
+          << std::setw(8) << std::setprecision(1) << percent;
+      }
+      out << std::setw(6) << number << "  " << code << '\n';
+    }
+  }
+}
+
+void LineProfiler::writeLcov(std::ostream& out){
+  for(const auto& [file, fileLines] : lines()){
+    std::error_code error;
+    auto path = std::filesystem::absolute(file, error).lexically_normal();
+
+    out << "TN:\n";
+    out << "SF:" << (error ? file : path.string()) << '\n';
+    size_t hit = 0;
+    for(const auto& [number, line] : fileLines){
+      out << "DA:" << number << ',' << line.hits << '\n';
+      if(line.hits > 0) ++hit;
+    }
+    out << "LF:" << fileLines.size() << '\n';
+    out << "LH:" << hit << '\n';
+    out << "end_of_record\n";
+  }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <iosfwd>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../parser/Visitor.hpp"
+
+/* Line-level profiler enabled with `ter --line-profile`. Hit counts and self
+   time live on the statement nodes themselves; the profiler only keeps the
+   nested timing stack and the list of statements to report on, so lines that
+   never ran show up as uncovered. */
+class LineProfiler {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    // Times one statement, excluding the statements nested in it
+    class Scope {
+      public:
+        Scope(LineProfiler& profiler, Statement::Stmt& stmt);
+        ~Scope();
+
+      private:
+        LineProfiler& profiler;
+        Statement::Stmt& stmt;
+        clock::time_point start;
+    };
+
+    void add(const std::vector<std::shared_ptr<Statement::Stmt>>& statements);
+    void addSource(const std::string& file, const std::string& source);
+
+    void report(std::ostream& out);
+    void writeLcov(std::ostream& out);
+
+  private:
+    struct Line {
+      uint64_t hits = 0;
+      int64_t selfNs = 0;
+    };
+
+    std::vector<std::shared_ptr<Statement::Stmt>> nodes;
+    std::vector<int64_t> children;
+    std::map<std::string, std::string> sources;
+
+    std::map<std::string, std::map<int, Line>> lines();
+};
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Parallel.hpp"
+#include "Isolate.hpp"
+#include "../utils/Epoch.hpp"
+#include "../utils/ThreadPool.hpp"
+
+namespace {
+  // Chunks per thread: enough to balance uneven items by stealing
+  constexpr size_t chunksPerThread = 8;
+
+  // Worker isolate of one thread in one section. A thread waiting in a
+  // nested section may run another chunk of this one meanwhile; the item it
+  // suspended keeps its worker, so the chunk gets one of its own.
+  struct Worker {
+    std::string out;
+    std::ostringstream errors;
+    Isolate isolate;
+    bool busy = false;
+
+    Worker(Isolate& parent, uint64_t epoch) : isolate{parent, epoch, &out, errors} {}
+  };
+
+  class Section {
+    public:
+      Section(const std::any& function, const std::vector<std::any>& arguments) :
+        fn{function}, inputs{arguments}, results(arguments.size()), outputs(arguments.size()),
+        parent{Isolate::current()}, epoch{Epoch::next()} {}
+
+      void run(size_t begin, size_t end){
+        Worker& worker = acquire();
+        Isolate::Scope scope{worker.isolate};
+        for(size_t i = begin; i < end && i < failedAt.load(); ++i){
+          try{
+            results[i] = worker.isolate.interpreter.call(fn, {inputs[i]});
+            worker.isolate.settle();
+          }catch(...){
+            fail(i, std::current_exception());
+          }
+          worker.isolate.output.flush();
+          outputs[i] = std::move(worker.out);
+          worker.out.clear();
+        }
+        release(worker);
+      }
+
+      // Writes the buffered output in input order, then raises the first error
+      std::vector<std::any> finish(){
+        // Output of the failing call is kept, as it was printed before the error
+        size_t last = error ? failedAt.load() + 1 : inputs.size();
+        for(size_t i = 0; i < last; ++i){
+          if(!outputs[i].empty()) parent.output.write(outputs[i]);
+        }
+        for(auto& [id, owned] : workers){
+          for(const std::unique_ptr<Worker>& worker : owned){
+            std::string text = worker->errors.str();
+            if(!text.empty()){
+              parent.output.flush();
+              parent.errors << text;
+            }
+          }
+        }
+        if(error){
+          std::rethrow_exception(error);
+        }
+        return std::move(results);
+      }
+
+    private:
+      const std::any& fn;
+      const std::vector<std::any>& inputs;
+      std::vector<std::any> results;
+      std::vector<std::string> outputs;
+      Isolate& parent;
+      uint64_t epoch;
+
+      std::mutex lock;
+      std::unordered_map<std::thread::id, std::vector<std::unique_ptr<Worker>>> workers;
+      std::atomic<size_t> failedAt{std::numeric_limits<size_t>::max()};
+      std::exception_ptr error;
+
+      // An idle worker of this thread, created if all are busy
+      Worker& acquire(){
+        std::lock_guard<std::mutex> guard(lock);
+        std::vector<std::unique_ptr<Worker>>& owned = workers[std::this_thread::get_id()];
+        for(const std::unique_ptr<Worker>& worker : owned){
+          if(!worker->busy){
+            worker->busy = true;
+            return *worker;
+          }
+        }
+        owned.push_back(std::make_unique<Worker>(parent, epoch));
+        owned.back()->busy = true;
+        return *owned.back();
+      }
+
+      void release(Worker& worker){
+        std::lock_guard<std::mutex> guard(lock);
+        worker.busy = false;
+      }
+
+      // Keeps the error of the lowest input; later inputs are skipped
+      void fail(size_t index, std::exception_ptr exception){
+        std::lock_guard<std::mutex> guard(lock);
+        if(index < failedAt.load()){
+          failedAt = index;
+          error = exception;
+        }
+      }
+  };
+}
+
+std::vector<std::any> Parallel::map(const std::any& fn, const std::vector<std::any>& inputs){
+  Section section{fn, inputs};
+  ThreadPool& pool = ThreadPool::get_instance();
+  size_t grain = std::max<size_t>(1, inputs.size() / (pool.concurrency() * chunksPerThread));
+
+  std::atomic<size_t> remaining{(inputs.size() + grain - 1) / grain};
+  for(size_t begin = 0; begin < inputs.size(); begin += grain){
+    size_t end = std::min(begin + grain, inputs.size());
+    pool.submit([&section, &remaining, &pool, begin, end]{
+      section.run(begin, end);
+      if(--remaining == 0) pool.notifyWaiters();
+    });
+  }
+  pool.helpUntil([&remaining]{ return remaining.load() == 0; });
+  return section.finish();
+}
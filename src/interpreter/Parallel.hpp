@@ -0,0 +1,22 @@
+#pragma once
+
+#include <any>
+#include <vector>
+
+class Interpreter;
+
+/* Runs a Ter function over many inputs on the ThreadPool, for the
+   parallel_map and parallel_for builtins. Inputs are split into chunks
+   that idle threads steal from each other. Each thread calls the function
+   in a worker isolate of its own that reads the caller's globals and
+   captured variables but may only modify what it created itself.
+
+   What the calls print is buffered per input and written in input order
+   once all are done, so the output does not depend on scheduling. The
+   first error, in input order, stops the section and is raised in the
+   caller. */
+class Parallel {
+  public:
+    // Result of fn(input) for every input, in order
+    static std::vector<std::any> map(const std::any& fn, const std::vector<std::any>& inputs);
+};
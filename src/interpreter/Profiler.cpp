@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+
+#include "Profiler.hpp"
+#include "../utils/Stats.hpp"
+
+size_t Profiler::entryFor(const void* key, const std::string& name, int line, bool builtin){
+  auto it = index.find(key);
+  if(it != index.end()){
+    return it->second;
+  }
+
+  Entry entry;
+  entry.name = name;
+  entry.line = line;
+  entry.builtin = builtin;
+  entries.push_back(std::move(entry));
+  index.emplace(key, entries.size() - 1);
+  return entries.size() - 1;
+}
+
+void Profiler::enter(size_t entry){
+  ++entries[entry].calls;
+  ++entries[entry].active;
+  stack.push_back({entry, clock::now(), 0, Stats::allocations(), 0, Stats::readPerf(), {}});
+}
+
+void Profiler::leave(){
+  Frame frame = stack.back();
+  stack.pop_back();
+
+  int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - frame.start).count();
+  uint64_t allocated = Stats::allocations() - frame.allocStart;
+  PerfCounters::Sample perf = Stats::readPerf() - frame.perfStart;
+
+  Entry& entry = entries[frame.entry];
+  --entry.active;
+  // Recursive activations are already covered by the outermost one
+  if(entry.active == 0){
+    entry.inclusiveNs += elapsed;
+    entry.inclusiveAllocations += allocated;
+  }
+  entry.exclusiveNs += elapsed - frame.childNs;
+  entry.allocations += allocated - frame.childAllocations;
+  entry.exclusivePerf += perf - frame.childPerf;
+
+  if(!stack.empty()){
+    stack.back().childNs += elapsed;
+    stack.back().childAllocations += allocated;
+    stack.back().childPerf += perf;
+  }
+}
+
+std::vector<Profiler::Entry> Profiler::sorted(){
+  std::vector<Entry> result = entries;
+  std::sort(result.begin(), result.end(), [](const Entry& a, const Entry& b){
+    return a.exclusiveNs > b.exclusiveNs;
+  });
+  return result;
+}
+
+void Profiler::report(std::ostream& out){
+  auto ms = [](int64_t ns){ return static_cast<double>(ns) / 1e6; };
+
+  out << "\nProfile (sorted by exclusive time)\n";
+  out << std::left << std::setw(32) << "function"
+    << std::right << std::setw(12) << "calls"
+    << std::setw(14) << "incl ms"
+    << std::setw(14) << "excl ms"
+    << std::setw(12) << "allocs";
+  if(PerfCounters::enabled){
+    out << std::setw(16) << "instructions" << std::setw(8) << "IPC"
+      << std::setw(14) << "branch miss" << std::setw(14) << "cache miss";
+  }
+  out << '\n';
+
+  out << std::fixed << std::setprecision(3);
+  for(const Entry& entry : sorted()){
+    std::string label = entry.builtin ? entry.name + " (builtin)"
+      : entry.name + " (line " + std::to_string(entry.line) + ")";
+    out << std::left << std::setw(32) << label
+      << std::right << std::setw(12) << entry.calls
+      << std::setw(14) << ms(entry.inclusiveNs)
+      << std::setw(14) << ms(entry.exclusiveNs)
+      << std::setw(12) << entry.allocations;
+    if(PerfCounters::enabled){
+      const PerfCounters::Sample& perf = entry.exclusivePerf;
+      out << std::setw(16) << perf.instructions
+        << std::setw(8) << std::setprecision(2) << perf.ipc() << std::setprecision(3)
+        << std::setw(14) << perf.branchMisses << std::setw(14) << perf.cacheMisses;
+    }
+    out << '\n';
+  }
+}
+
+void Profiler::writeJson(std::ostream& out){
+  out << "{\"functions\":[";
+  bool first = true;
+  for(const Entry& entry : sorted()){
+    if(!first) out << ',';
+    first = false;
+    // Names are Ter identifiers: nothing to escape
+    out << "{\"name\":\"" << entry.name << "\""
+      << ",\"line\":" << entry.line
+      << ",\"builtin\":" << (entry.builtin ? "true" : "false")
+      << ",\"calls\":" << entry.calls
+      << ",\"inclusive_ns\":" << entry.inclusiveNs
+      << ",\"exclusive_ns\":" << entry.exclusiveNs
+      << ",\"allocations\":" << entry.allocations
+      << ",\"inclusive_allocations\":" << entry.inclusiveAllocations;
+    if(PerfCounters::enabled){
+      out << ",\"instructions\":" << entry.exclusivePerf.instructions
+        << ",\"cycles\":" << entry.exclusivePerf.cycles
+        << ",\"branch_misses\":" << entry.exclusivePerf.branchMisses
+        << ",\"cache_misses\":" << entry.exclusivePerf.cacheMisses;
+    }
+    out << '}';
+  }
+  out << "]}\n";
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../utils/PerfCounters.hpp"
+
+/* Function-level profiler enabled with `ter --profile`. The interpreter
+   calls enter()/leave() around every user function and builtin call while a
+   profiler is attached; when none is attached the only cost is a null check. */
+class Profiler {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    struct Entry {
+      std::string name;
+      int line = 0;
+      bool builtin = false;
+      uint64_t calls = 0;
+      int64_t inclusiveNs = 0;
+      int64_t exclusiveNs = 0;
+      uint64_t allocations = 0;
+      uint64_t inclusiveAllocations = 0;
+      PerfCounters::Sample exclusivePerf;
+      int active = 0;
+    };
+
+    size_t entryFor(const void* key, const std::string& name, int line, bool builtin);
+    void enter(size_t entry);
+    void leave();
+
+    void report(std::ostream& out);
+    void writeJson(std::ostream& out);
+
+  private:
+    struct Frame {
+      size_t entry;
+      clock::time_point start;
+      int64_t childNs;
+      uint64_t allocStart;
+      uint64_t childAllocations;
+      PerfCounters::Sample perfStart;
+      PerfCounters::Sample childPerf;
+    };
+
+    std::unordered_map<const void*, size_t> index;
+    std::vector<Entry> entries;
+    std::vector<Frame> stack;
+
+    std::vector<Entry> sorted();
+};
@@ -0,0 +1,20 @@
+#include <algorithm>
+#include <cmath>
+
+#include "Range.hpp"
+
+// Clamped so absurd bounds still convert; no loop gets that far anyway
+Range::Range(double from, double to, double by) : start{from}, step{by},
+  count{static_cast<int64_t>(std::clamp(std::ceil((to - from) / by), 0.0, 0x1p62))} {}
+
+int64_t Range::size() const {
+  return count;
+}
+
+double Range::at(int64_t i) const {
+  return start + static_cast<double>(i) * step;
+}
+
+std::string Range::toString() const {
+  return "<range>";
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/* Numbers from start up to, but not including, stop, step apart: what
+   range() returns. for-in walks it without building an array, so a
+   range of a billion numbers costs as little as one of ten. Ranges never
+   change, so every thread may share one. */
+class Range {
+  public:
+    // by is never 0
+    Range(double from, double to, double by);
+
+    // How many numbers there are
+    int64_t size() const;
+    // The i-th number; computed from start, so long ranges do not drift
+    double at(int64_t i) const;
+    std::string toString() const;
+
+  private:
+    double start;
+    double step;
+    int64_t count;
+};
@@ -180,6 +180,24 @@ std::any Resolver::visitReturnStmt(std::shared_ptr<Statement::Return> stmt){
   return {};
 }
 
+std::any Resolver::visitYieldStmt(std::shared_ptr<Statement::Yield> stmt){
+  if(currentFunction == FType::NONE){
+    Debug::error(stmt->keyword, "Can't yield from top level code.");
+  }
+  resolve(stmt->value);
+  return {};
+}
+
+std::any Resolver::visitForInStmt(std::shared_ptr<Statement::ForIn> stmt){
+  resolve(stmt->iterable);
+  beginScope();
+  declare(stmt->name);
+  define(stmt->name);
+  resolve(stmt->body);
+  endScope();
+  return {};
+}
+
 std::any Resolver::visitClassStmt(std::shared_ptr<Statement::Class> stmt){
   declare(stmt->name);
   define(stmt->name);
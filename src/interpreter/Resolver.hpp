@@ -51,6 +51,8 @@ class Resolver : public ExprVisitor, public Statement::StmtVisitor {
     std::any visitReturnStmt(std::shared_ptr<Statement::Return> stmt) override;
     std::any visitClassStmt(std::shared_ptr<Statement::Class> stmt) override;
     std::any visitIncludeStmt(std::shared_ptr<Statement::Include> stmt) override;
+    std::any visitYieldStmt(std::shared_ptr<Statement::Yield> stmt) override;
+    std::any visitForInStmt(std::shared_ptr<Statement::ForIn> stmt) override;
     std::any visitGetExpr(std::shared_ptr<Get> expr) override;
     std::any visitSetExpr(std::shared_ptr<Set> expr) override;
     std::any visitArrayExpr(std::shared_ptr<Array> expr) override;
@@ -0,0 +1,275 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/time.h>
+#endif
+
+#include "Sampler.hpp"
+
+namespace {
+  int64_t nowNanos(){
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+  }
+
+  // Minimal protobuf encoding, enough for pprof's profile.proto
+  void varint(std::string& out, uint64_t value){
+    while(value >= 0x80){
+      out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+  }
+
+  void field(std::string& out, uint32_t number, uint64_t value){
+    varint(out, uint64_t{number} << 3);
+    varint(out, value);
+  }
+
+  void field(std::string& out, uint32_t number, const std::string& bytes){
+    varint(out, (uint64_t{number} << 3) | 2);
+    varint(out, bytes.size());
+    out.append(bytes);
+  }
+
+  void packed(std::string& out, uint32_t number, const std::vector<uint64_t>& values){
+    std::string bytes;
+    for(uint64_t value : values){
+      varint(bytes, value);
+    }
+    field(out, number, bytes);
+  }
+}
+
+Sampler::Sampler(int frequency) : frequency{frequency}, ring(ringSize) {
+  labels.push_back({"main", 0});
+}
+
+Sampler::~Sampler(){
+  stop();
+}
+
+void Sampler::start(){
+#ifndef _WIN32
+  if(running) return;
+  active = this;
+
+  struct sigaction action{};
+  action.sa_handler = &Sampler::onSignal;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGPROF, &action, nullptr);
+
+  struct itimerval timer{};
+  timer.it_interval.tv_usec = 1000000 / frequency;
+  timer.it_value = timer.it_interval;
+  setitimer(ITIMER_PROF, &timer, nullptr);
+
+  running = true;
+  startNanos = nowNanos();
+#else
+  std::cerr << "Sampling profiler is not supported on this platform.\n";
+#endif
+}
+
+void Sampler::stop(){
+#ifndef _WIN32
+  if(!running) return;
+
+  struct itimerval timer{};
+  setitimer(ITIMER_PROF, &timer, nullptr);
+  signal(SIGPROF, SIG_IGN);
+
+  running = false;
+  active = nullptr;
+  durationNanos = nowNanos() - startNanos;
+  drain();
+#endif
+}
+
+void Sampler::ignoreOnThisThread(){
+#ifndef _WIN32
+  sigset_t set;
+  sigemptyset(&set);
+  sigaddset(&set, SIGPROF);
+  pthread_sigmask(SIG_BLOCK, &set, nullptr);
+#endif
+}
+
+void Sampler::onSignal(int){
+  if(active != nullptr){
+    active->sample();
+  }
+}
+
+// Runs inside the signal handler: no allocation, no locks
+void Sampler::sample(){
+  int d = depth.load(std::memory_order_relaxed);
+  if(d > maxDepth) d = maxDepth;
+
+  size_t h = head.load(std::memory_order_relaxed);
+  size_t used = h - tail.load(std::memory_order_relaxed);
+  size_t need = static_cast<size_t>(d) + 1;
+  if(ringSize - used < need){
+    dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  ring[h % ringSize] = static_cast<uint32_t>(d);
+  for(int i = 0; i < d; ++i){
+    ring[(h + 1 + static_cast<size_t>(i)) % ringSize] = frames[i];
+  }
+  std::atomic_signal_fence(std::memory_order_release);
+  head.store(h + need, std::memory_order_relaxed);
+}
+
+void Sampler::drain(){
+  size_t h = head.load(std::memory_order_relaxed);
+  std::atomic_signal_fence(std::memory_order_acquire);
+  size_t t = tail.load(std::memory_order_relaxed);
+
+  while(t < h){
+    uint32_t d = ring[t % ringSize];
+    std::vector<uint32_t> stack;
+    stack.reserve(d);
+    for(uint32_t i = 0; i < d; ++i){
+      stack.push_back(ring[(t + 1 + i) % ringSize]);
+    }
+    ++stacks[stack];
+    t += d + 1;
+  }
+  tail.store(t, std::memory_order_relaxed);
+}
+
+uint32_t Sampler::labelFor(const void* key, const std::string& name, int line){
+  auto it = index.find(key);
+  if(it != index.end()){
+    return it->second;
+  }
+  labels.push_back({name, line});
+  uint32_t label = static_cast<uint32_t>(labels.size() - 1);
+  index.emplace(key, label);
+  return label;
+}
+
+void Sampler::push(uint32_t label){
+  int d = depth.load(std::memory_order_relaxed);
+  if(d < maxDepth){
+    frames[d] = label;
+  }
+  std::atomic_signal_fence(std::memory_order_release);
+  depth.store(d + 1, std::memory_order_relaxed);
+
+  // Fold samples before the ring fills up
+  if(head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed) > ringSize / 2){
+    drain();
+  }
+}
+
+void Sampler::pop(){
+  depth.store(depth.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+}
+
+void Sampler::writeFolded(std::ostream& out){
+  drain();
+  for(const auto& [stack, count] : stacks){
+    out << labels[0].name;
+    for(uint32_t label : stack){
+      out << ';' << labels[label].name;
+      if(labels[label].line > 0){
+        out << ":" << labels[label].line;
+      }
+    }
+    out << ' ' << count << '\n';
+  }
+}
+
+void Sampler::writePprof(std::ostream& out){
+  drain();
+
+  // String table: index 0 must be the empty string
+  std::vector<std::string> strings{"", "samples", "count", "cpu", "nanoseconds"};
+  auto stringIndex = [&strings](const std::string& text){
+    strings.push_back(text);
+    return static_cast<uint64_t>(strings.size() - 1);
+  };
+
+  std::string profile;
+  std::string valueType;
+  field(valueType, 1, 1);
+  field(valueType, 2, 2);
+  field(profile, 1, valueType);
+  valueType.clear();
+  field(valueType, 1, 3);
+  field(valueType, 2, 4);
+  field(profile, 1, valueType);
+
+  const int64_t period = 1000000000 / frequency;
+  for(const auto& [stack, count] : stacks){
+    // pprof lists the leaf first; ids are label + 1 since 0 is reserved
+    std::vector<uint64_t> locations;
+    for(auto it = stack.rbegin(); it != stack.rend(); ++it){
+      locations.push_back(*it + 1);
+    }
+    locations.push_back(1);
+    std::string sample;
+    packed(sample, 1, locations);
+    packed(sample, 2, {count, count * static_cast<uint64_t>(period)});
+    field(profile, 2, sample);
+  }
+
+  for(size_t i = 0; i < labels.size(); ++i){
+    uint64_t id = i + 1;
+    std::string line;
+    field(line, 1, id);
+    field(line, 2, static_cast<uint64_t>(labels[i].line));
+    std::string location;
+    field(location, 1, id);
+    field(location, 4, line);
+    field(profile, 4, location);
+
+    std::string function;
+    field(function, 1, id);
+    field(function, 2, stringIndex(labels[i].name));
+    field(function, 5, static_cast<uint64_t>(labels[i].line));
+    field(profile, 5, function);
+  }
+
+  for(const std::string& text : strings){
+    field(profile, 6, text);
+  }
+  field(profile, 9, static_cast<uint64_t>(startNanos));
+  field(profile, 10, static_cast<uint64_t>(durationNanos));
+  valueType.clear();
+  field(valueType, 1, 3);
+  field(valueType, 2, 4);
+  field(profile, 11, valueType);
+  field(profile, 12, static_cast<uint64_t>(period));
+
+  out.write(profile.data(), static_cast<std::streamsize>(profile.size()));
+}
+
+void Sampler::write(const std::string& path){
+  auto endsWith = [&path](const std::string& suffix){
+    return path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+  };
+
+  std::ofstream file(path, std::ios::binary);
+  if(!file){
+    std::cerr << "Cannot write samples to '" << path << "'.\n";
+    return;
+  }
+
+  if(endsWith(".pb") || endsWith(".pprof")){
+    writePprof(file);
+  }else{
+    writeFolded(file);
+  }
+
+  if(dropped.load() != 0){
+    std::cerr << "Sampling profiler dropped " << dropped.load() << " samples.\n";
+  }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Sampling profiler enabled with `ter --sample-profile=out.folded`. While
+   attached, the interpreter keeps a shadow stack of active Ter calls; a
+   SIGPROF timer copies that stack into a ring buffer from the signal
+   handler, and the ring is folded into per-stack counts outside of it.
+
+   Output is in collapsed-stack format for flame graphs, or pprof protobuf
+   when the file name ends in .pb or .pprof. */
+class Sampler {
+  public:
+    explicit Sampler(int frequency = 997);
+    ~Sampler();
+
+    void start();
+    void stop();
+    // SIGPROF goes to any thread of the process, but only the one running
+    // the profiled script may sample; other threads block it at startup
+    static void ignoreOnThisThread();
+
+    uint32_t labelFor(const void* key, const std::string& name, int line);
+    void push(uint32_t label);
+    void pop();
+
+    void writeFolded(std::ostream& out);
+    void writePprof(std::ostream& out);
+    void write(const std::string& path);
+
+  private:
+    static constexpr int maxDepth = 1024;
+    static constexpr size_t ringSize = 1 << 20;
+
+    struct Label {
+      std::string name;
+      int line;
+    };
+
+    int frequency;
+    bool running = false;
+    int64_t startNanos = 0;
+    int64_t durationNanos = 0;
+
+    // Shadow stack: written by the interpreter, read by the signal handler
+    uint32_t frames[maxDepth];
+    std::atomic<int> depth{0};
+
+    // Samples as [depth, label...] records between tail and head
+    std::vector<uint32_t> ring;
+    std::atomic<size_t> head{0};
+    std::atomic<size_t> tail{0};
+    std::atomic<uint64_t> dropped{0};
+
+    std::unordered_map<const void*, uint32_t> index;
+    std::vector<Label> labels;
+    std::map<std::vector<uint32_t>, uint64_t> stacks;
+
+    inline static Sampler* active = nullptr;
+    static void onSignal(int);
+    void sample();
+    void drain();
+};
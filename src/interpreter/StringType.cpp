@@ -0,0 +1,164 @@
+#include <array>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "StringType.hpp"
+#include "HeapProfiler.hpp"
+#include "../utils/Stats.hpp"
+
+namespace {
+  // Concatenations up to this size are copied into one flat buffer; past it a
+  // rope node is created. Short tails are merged into the previous leaf so a
+  // rope built by appending small pieces stays shallow.
+  constexpr size_t ropeLeafSize = 256;
+
+  // Guards rope children, which are released once a rope has been flattened
+  std::mutex ropeLock;
+}
+
+StringType::StringType(std::string value) :
+  value{std::move(value)}, len{this->value.length()}, flat{true} {
+  ++Stats::get().strings;
+  if(HeapProfiler::active != nullptr) HeapProfiler::active->track(this, HeapProfiler::Kind::String);
+}
+
+StringType::StringType(std::shared_ptr<StringType> left, std::shared_ptr<StringType> right) :
+  left{std::move(left)}, right{std::move(right)},
+  len{this->left->length() + this->right->length()}, flat{false} {
+  ++Stats::get().strings;
+  if(HeapProfiler::active != nullptr) HeapProfiler::active->track(this, HeapProfiler::Kind::String);
+}
+
+StringType::~StringType(){
+  if(HeapProfiler::active != nullptr) HeapProfiler::active->release(this);
+
+  // Release rope chains iteratively so a long one cannot overflow the stack
+  std::vector<std::shared_ptr<StringType>> pending;
+  if(left) pending.push_back(std::move(left));
+  if(right) pending.push_back(std::move(right));
+  while(!pending.empty()){
+    std::shared_ptr<StringType> node = std::move(pending.back());
+    pending.pop_back();
+    if(node.use_count() == 1){
+      if(node->left) pending.push_back(std::move(node->left));
+      if(node->right) pending.push_back(std::move(node->right));
+    }
+  }
+}
+
+std::shared_ptr<StringType> StringType::intern(std::string_view text){
+  static std::mutex lock;
+  static std::unordered_map<std::string_view, std::shared_ptr<StringType>> table;
+
+  std::lock_guard<std::mutex> guard(lock);
+  auto it = table.find(text);
+  if(it != table.end()){
+    return it->second;
+  }
+
+  auto str = std::make_shared<StringType>(std::string{text});
+  // The key views the interned characters, which never move or die
+  table.emplace(std::string_view{str->value}, str);
+  return str;
+}
+
+std::shared_ptr<StringType> StringType::character(char c){
+  static const auto table = []{
+    std::array<std::shared_ptr<StringType>, 256> strings;
+    for(size_t i = 0; i < strings.size(); ++i){
+      strings[i] = std::make_shared<StringType>(std::string(1, static_cast<char>(i)));
+    }
+    return strings;
+  }();
+  return table[static_cast<unsigned char>(c)];
+}
+
+std::shared_ptr<StringType> StringType::concat(const std::shared_ptr<StringType>& left,
+    const std::shared_ptr<StringType>& right){
+  if(left->len == 0) return right;
+  if(right->len == 0) return left;
+
+  // Both sides are flat: only strings longer than a leaf are ropes
+  if(left->len + right->len <= ropeLeafSize){
+    std::string result;
+    result.reserve(left->len + right->len);
+    result.append(left->value).append(right->value);
+    return std::make_shared<StringType>(std::move(result));
+  }
+
+  if(right->len < ropeLeafSize){
+    std::shared_ptr<StringType> head, tail;
+    {
+      std::lock_guard<std::mutex> guard(ropeLock);
+      if(left->isRope()){
+        head = left->left;
+        tail = left->right;
+      }
+    }
+    if(tail && !tail->isRope() && tail->len + right->len <= ropeLeafSize){
+      return std::make_shared<StringType>(std::move(head), concat(tail, right));
+    }
+  }
+
+  return std::make_shared<StringType>(left, right);
+}
+
+bool StringType::isRope() const {
+  return !flat.load(std::memory_order_acquire);
+}
+
+void StringType::flatten() const {
+  std::lock_guard<std::mutex> guard(ropeLock);
+  if(!isRope()) return;
+
+  std::string result;
+  result.reserve(len);
+  std::vector<const StringType*> pending{right.get(), left.get()};
+  while(!pending.empty()){
+    const StringType* node = pending.back();
+    pending.pop_back();
+    if(node->isRope()){
+      pending.push_back(node->right.get());
+      pending.push_back(node->left.get());
+    }else{
+      result.append(node->value);
+    }
+  }
+
+  value = std::move(result);
+  left.reset();
+  right.reset();
+  flat.store(true, std::memory_order_release);
+}
+
+const std::string& StringType::str() const {
+  if(isRope()) flatten();
+  return value;
+}
+
+size_t StringType::length() const {
+  return len;
+}
+
+size_t StringType::hash() const {
+  size_t h = cachedHash.load(std::memory_order_relaxed);
+  if(h == 0){
+    h = std::hash<std::string>{}(str());
+    // Zero marks "not computed yet"
+    if(h == 0){ h = 1; }
+    cachedHash.store(h, std::memory_order_relaxed);
+  }
+  return h;
+}
+
+bool StringType::equals(const StringType& other) const {
+  if(this == &other) return true;
+  if(length() != other.length()) return false;
+  // Hashes are only compared when both are already known: computing them
+  // here would cost more than the comparison itself
+  size_t h = cachedHash.load(std::memory_order_relaxed);
+  size_t o = other.cachedHash.load(std::memory_order_relaxed);
+  if(h != 0 && o != 0 && h != o) return false;
+  return str() == other.str();
+}
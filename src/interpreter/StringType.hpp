@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+/* Immutable string value shared by reference between the AST, environments
+   and arrays. Copying a Ter string copies the pointer, never the characters.
+
+   Long concatenations build a rope (left + right) instead of copying both
+   sides; the rope is flattened into a single buffer the first time its
+   characters are needed, so `s = s + piece` in a loop stays linear. */
+class StringType {
+  private:
+    mutable std::string value;
+    mutable std::shared_ptr<StringType> left;
+    mutable std::shared_ptr<StringType> right;
+    const size_t len;
+    mutable std::atomic<bool> flat;
+    mutable std::atomic<size_t> cachedHash{0};
+
+    void flatten() const;
+    bool isRope() const;
+
+  public:
+    explicit StringType(std::string value);
+    StringType(std::shared_ptr<StringType> left, std::shared_ptr<StringType> right);
+    ~StringType();
+
+    // Literals are interned once at scan time and live for the whole process
+    static std::shared_ptr<StringType> intern(std::string_view text);
+    // One-character string, shared like a literal
+    static std::shared_ptr<StringType> character(char c);
+    static std::shared_ptr<StringType> concat(const std::shared_ptr<StringType>& left,
+        const std::shared_ptr<StringType>& right);
+
+    const std::string& str() const;
+    size_t length() const;
+    size_t hash() const;
+    bool equals(const StringType& other) const;
+};
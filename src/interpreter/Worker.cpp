@@ -0,0 +1,101 @@
+#include <iterator>
+
+#include "Worker.hpp"
+#include "Isolate.hpp"
+#include "Channel.hpp"
+#include "Sampler.hpp"
+#include "../Ter.hpp"
+#include "../utils/RuntimeError.hpp"
+
+Worker::Worker(Isolate& owner, Bundle arguments) :
+  parent{owner}, args{owner.args}, dir{owner.dir}, values{std::move(arguments)},
+  argumentCount{values.values.size()} {
+  // Writing straight to stdout/stderr is safe; a captured string is not
+  direct = !parent.output.captures() && &parent.errors == &std::cerr;
+  for(const std::any& argument : values.values){
+    if(argument.type() == typeid(std::shared_ptr<Channel>)){
+      channels.push_back(std::any_cast<const std::shared_ptr<Channel>&>(argument));
+    }
+  }
+}
+
+Worker::Worker(Isolate& owner, const std::filesystem::path& path, Bundle arguments) :
+  Worker{owner, std::move(arguments)} {
+  thread = std::thread([this, path]{ runScript(path); });
+}
+
+Worker::Worker(Isolate& owner, const std::any& function, Bundle arguments) :
+  Worker{owner, std::move(arguments)} {
+  // Copied here, while the parent cannot change them under us, and in the
+  // same bundle as the arguments so values they share stay shared
+  values.add(function);
+  std::vector<std::string> globals;
+  for(const auto& [name, value] : parent.interpreter.global->entries()){
+    if(values.add(value)){
+      globals.push_back(name);
+    }
+  }
+  auto locals = std::make_shared<Locals>(*parent.interpreter.locals);
+
+  thread = std::thread([this, globals = std::move(globals), locals]() mutable {
+    runFunction(std::move(globals), std::move(locals));
+  });
+}
+
+Worker::~Worker(){
+  thread.join();
+  if(!direct){
+    parent.output.write(out);
+    parent.output.flush();
+    parent.errors << errors.str();
+  }
+}
+
+void Worker::runScript(const std::filesystem::path& path){
+  Sampler::ignoreOnThisThread();
+  Isolate isolate{args, direct ? nullptr : &out, direct ? std::cerr : errors};
+  isolate.dir = path.parent_path();
+  Isolate::Scope scope{isolate};
+  isolate.workerArgs = values.adopt();
+  isolate.isWorkerScript = true;
+  if(Ter::run_file(path.string()) != 0){
+    closeChannels();
+  }
+  isolate.output.flush();
+}
+
+void Worker::runFunction(std::vector<std::string> globals, std::shared_ptr<Locals> locals){
+  Sampler::ignoreOnThisThread();
+  Isolate isolate{args, direct ? nullptr : &out, direct ? std::cerr : errors};
+  isolate.dir = dir;
+  Isolate::Scope scope{isolate};
+  Interpreter& interpreter = isolate.interpreter;
+
+  std::vector<std::any> adopted = values.adopt();
+  std::vector<std::any> arguments(std::make_move_iterator(adopted.begin()),
+    std::make_move_iterator(adopted.begin() + static_cast<std::ptrdiff_t>(argumentCount)));
+  std::any function = std::move(adopted[argumentCount]);
+  // Builtins are already there; the rest are the parent's globals
+  for(size_t i = 0; i < globals.size(); ++i){
+    if(!interpreter.global->entries().contains(globals[i])){
+      interpreter.global->define(globals[i], std::move(adopted[argumentCount + 1 + i]));
+    }
+  }
+  interpreter.locals = std::move(locals);
+
+  try{
+    interpreter.call(function, std::move(arguments));
+  }catch(const RuntimeError& error){
+    Debug::runtimeError(error);
+    closeChannels();
+  }catch(const Isolate::Exit&){
+    closeChannels();
+  }
+  isolate.output.flush();
+}
+
+void Worker::closeChannels(){
+  for(const std::shared_ptr<Channel>& channel : channels){
+    channel->close();
+  }
+}
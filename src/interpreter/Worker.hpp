@@ -0,0 +1,62 @@
+#pragma once
+
+#include <any>
+#include <filesystem>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Channel.hpp"
+
+struct Expr;
+class Isolate;
+
+/* Isolate running on a thread of its own, started by spawn_worker(). A
+   script worker runs a file in a fresh isolate; a function worker calls a
+   top-level function in an isolate that starts with copies of the
+   caller's globals. Either way nothing mutable is shared: arguments are
+   copied like channel messages, and channels are how workers talk.
+
+   A function that stops on an error, or a script that exits with an error
+   status, closes the channels it was given, so the stages around it see
+   the end of the stream instead of waiting forever.
+
+   Workers print straight to stdout and stderr unless the parent captures
+   its output (tests, embedders); then the worker's output is appended to
+   the parent's when it is joined. The parent joins its workers when it
+   is destroyed. */
+class Worker {
+  public:
+    // Runs the script at path; args() in it returns arguments
+    Worker(Isolate& parent, const std::filesystem::path& path, Bundle arguments);
+    // Calls function(arguments...); the parent's globals join the bundle
+    Worker(Isolate& parent, const std::any& function, Bundle arguments);
+    ~Worker();
+
+    Worker(const Worker&) = delete;
+    void operator=(const Worker&) = delete;
+
+  private:
+    using Locals = std::unordered_map<std::shared_ptr<Expr>, int>;
+
+    Isolate& parent;
+    bool direct;
+    std::string out;
+    std::ostringstream errors;
+    std::vector<std::string> args;
+    std::filesystem::path dir;
+    // Arguments, then for function workers the function and the globals
+    Bundle values;
+    size_t argumentCount;
+    std::vector<std::shared_ptr<Channel>> channels;
+    std::thread thread;
+
+    Worker(Isolate& parent, Bundle arguments);
+    void runScript(const std::filesystem::path& path);
+    void runFunction(std::vector<std::string> globals, std::shared_ptr<Locals> locals);
+    void closeChannels();
+};
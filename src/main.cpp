@@ -1,49 +1,118 @@
 #include <iostream>
+#include <cstdlib>
 
 #include "Ter.hpp"
-#include "utils/Helpers.hpp"
+#include "TestRunner.hpp"
+#include "interpreter/Isolate.hpp"
 
 void help(const std::string& prog){
   std::cerr << "Ter/Terlang v0.1.6\n\n";
   std::cerr << "Usage: \n\t" <<
-    prog << " [filename].ter\n\t" << 
-    prog << " -e '<script>'\n";
+    prog << " [options] [filename].ter\n\t" <<
+    prog << " [options] -e '<script>'\n\t" <<
+    prog << " --test <dir>\n";
+  std::cerr << "\nOptions:\n"
+    "\t--stats  Phase times, counts and peak memory at exit\n"
+    "\t--heap-profile  Live Ter objects by type and allocating line at exit\n"
+    "\t--perf  Add hardware counters to --stats, --profile and bench()\n"
+    "\t--profile[=out.json]  Per-function calls and times at exit\n"
+    "\t--sample-profile=out.folded|out.pb  Sampled Ter call stacks\n"
+    "\t--line-profile[=lcov.info]  Per-line counts and times, plus lcov coverage\n"
+    "\t--trace=trace.json  Chrome/Perfetto trace of phases, includes, exec() and slow calls\n"
+    "\t--trace-threshold=US  Shortest call kept in the trace, default 1000\n";
+}
+
+// Returns false when arg is not a diagnostic option
+bool parse_option(const std::string& arg){
+  if(arg == "--stats"){
+    Ter::options.stats = true;
+    return true;
+  }
+  if(arg == "--perf"){
+    Ter::options.perf = true;
+    return true;
+  }
+  if(arg == "--heap-profile"){
+    Ter::options.heapProfile = true;
+    return true;
+  }
+  if(arg == "--profile"){
+    Ter::options.profile = true;
+    return true;
+  }
+  if(arg.rfind("--profile=", 0) == 0){
+    Ter::options.profile = true;
+    Ter::options.profileJson = arg.substr(10);
+    return true;
+  }
+  if(arg == "--line-profile"){
+    Ter::options.lineProfile = true;
+    return true;
+  }
+  if(arg.rfind("--line-profile=", 0) == 0 && arg.size() > 15){
+    Ter::options.lineProfile = true;
+    Ter::options.lineProfileLcov = arg.substr(15);
+    return true;
+  }
+  if(arg.rfind("--trace=", 0) == 0 && arg.size() > 8){
+    Ter::options.trace = arg.substr(8);
+    return true;
+  }
+  if(arg.rfind("--trace-threshold=", 0) == 0){
+    Ter::options.traceThresholdUs = std::atoll(arg.c_str() + 18);
+    return true;
+  }
+  if(arg.rfind("--sample-profile=", 0) == 0 && arg.size() > 17){
+    Ter::options.sampleProfile = arg.substr(17);
+    return true;
+  }
+  return false;
 }
 
 int main(int argc, char **argv){
 
-  if(argc >= 2){
+  int first = 1;
+  while(first < argc && parse_option(argv[first])){
+    ++first;
+  }
+
+  if(argc - first == 2 && std::string(argv[first]) == "--test"){
+    return TestRunner::run(argv[first + 1]);
+  }
+
+  if(argc - first >= 1){
+    // Scripts see the same args() with or without options
     std::vector<std::string> args;
-    for(int i = 0; i < argc; ++i){
+    args.emplace_back(argv[0]);
+    for(int i = first; i < argc; ++i){
       args.emplace_back(argv[i]);
     }
 
-    Helpers::get_instance().set_args(argc, args);
+    Isolate isolate{args};
+    Isolate::Scope scope{isolate};
 
-    const std::string arg1 = argv[1];
+    const std::string arg1 = argv[first];
 
     if(arg1 == "-e"){
-      if(argc != 3 || std::string(argv[2]).empty()) {
+      if(argc - first != 2 || std::string(argv[first + 1]).empty()) {
         std::cerr << "Error: Missing script argument after -e\n";
         return EXIT_FAILURE;
       }
-      Ter::run_script(argv[2]);
-      return EXIT_SUCCESS;
+      return Ter::run_script(argv[first + 1]);
     }
 
-    const std::string filename = argv[1];
+    const std::string filename = argv[first];
     const std::string hext = "\x2e\x74\x65\x72";
 
     if(filename.length() >= 4 && filename.substr(filename.length() - 4) == hext){
-      Ter::run_file(argv[1]);
-      return EXIT_SUCCESS;
+      return Ter::run_file(argv[first]);
     }
 
     help(argv[0]);
     return EXIT_FAILURE;
   }
 
-  Ter::repl();
-  return EXIT_SUCCESS;
+  Isolate isolate;
+  Isolate::Scope scope{isolate};
+  return Ter::repl();
 }
-
@@ -1,29 +1,28 @@
 #include <filesystem>
 #include <fstream>
 #include <algorithm>
-#include <iostream>
 
 #include "IncludeRun.hpp"
-#include "../utils/Debug.hpp"
+#include "../interpreter/Isolate.hpp"
 #include "../tokenizer/Scanner.hpp"
 
 namespace fs = std::filesystem;
 
-std::vector<Token> IncludeRun::tokens;
-
-void IncludeRun::scanFile(std::string path){
+std::vector<Token> IncludeRun::scanFile(std::string path){
   path.erase(remove( path.begin(), path.end(), '\"' ),path.end());
-  Debug::filename = path;
+  Isolate& isolate = Isolate::current();
+  isolate.debug.filename = path;
+  fs::path file_path = isolate.dir.empty() ? fs::path(path) : isolate.dir / path;
 
-  if(!fs::exists(path)){
-    std::cerr << "File '" << path << "' not found.\n";
-    std::exit(66);
+  if(!fs::exists(file_path)){
+    isolate.errors << "File '" << path << "' not found.\n";
+    throw Isolate::Exit{66};
   }
 
-  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  std::ifstream file(file_path, std::ios::binary | std::ios::ate);
   if(!file){
-    std::cerr << "Permission error opening file.\n";
-    std::exit(66);
+    isolate.errors << "Permission error opening file.\n";
+    throw Isolate::Exit{66};
   }
 
   std::streamsize size = file.tellg();
@@ -31,23 +30,13 @@ void IncludeRun::scanFile(std::string path){
   std::vector<char> buffer(static_cast<size_t>(size));
 
   if(!file.read(buffer.data(), size)){
-    std::cerr << "Error reading file.\n";
-    std::exit(77);
+    isolate.errors << "Error reading file.\n";
+    throw Isolate::Exit{77};
   }
 
   std::string content(buffer.begin(), buffer.end());
-  run(content);
-  if(Debug::hadError){ std::exit(65); }
-  if(Debug::hadRuntimeError){ std::exit(70); }
-}
-
-void IncludeRun::run(const std::string& source){
-  Scanner scanner(source);
-  IncludeRun::tokens = scanner.scanTokens();
-  if(Debug::hadError){ return; }
-}
-
-
-std::vector<Token> IncludeRun::getTokens(){
-  return IncludeRun::tokens;
+  Scanner scanner(content);
+  std::vector<Token> tokens = scanner.scanTokens();
+  if(isolate.debug.hadError){ throw Isolate::Exit{65}; }
+  return tokens;
 }
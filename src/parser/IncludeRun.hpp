@@ -4,8 +4,6 @@
 
 class IncludeRun {
   public:
-    static void scanFile(std::string path);
-    static void run(const std::string&);
-    static std::vector<Token> tokens;
-    static std::vector<Token> getTokens();
+    // Tokens of an included file, relative to the current isolate's directory
+    static std::vector<Token> scanFile(std::string path);
 };
@@ -4,12 +4,24 @@
 #include "Parser.hpp"
 #include "Expr.hpp"
 #include "../utils/Debug.hpp"
+#include "../utils/Tracer.hpp"
 #include "Stmt.hpp"
 #include "IncludeRun.hpp"
+#include "../interpreter/Isolate.hpp"
 
 #define assert(E)
 
-Parser::Parser(const std::vector<Token>& tokens) : tokens(tokens) {}
+Parser::Parser(const std::vector<Token>& tokens, const std::string& file) :
+  tokens(tokens), file{std::make_shared<const std::string>(file)} {}
+
+// Stamps the source position, unless a nested rule already did
+std::shared_ptr<Statement::Stmt> Parser::at(std::shared_ptr<Statement::Stmt> stmt, int line){
+  if(stmt != nullptr && stmt->line == 0){
+    stmt->line = line;
+    stmt->file = file;
+  }
+  return stmt;
+}
 
 std::vector<std::shared_ptr<Statement::Stmt>> Parser::parse(){
   statements.clear();
@@ -18,7 +30,7 @@ std::vector<std::shared_ptr<Statement::Stmt>> Parser::parse(){
       statements.push_back(declaration());
     }
   }catch(const std::exception& e) {
-    std::cerr << "[Exception parse]: " << e.what() << '\n'; 
+    Isolate::current().errors << "[Exception parse]: " << e.what() << '\n'; 
   }
   return statements;
 }
@@ -190,8 +202,10 @@ void Parser::synchronize(){
       //case TokenType::INCLUDE:
       case TokenType::CLASS:
       case TokenType::SET:
+      case TokenType::ASYNC:
       case TokenType::AUTO:
       case TokenType::FOR:
+      case TokenType::YIELD:
       case TokenType::IF:
       case TokenType::WHILE:
       case TokenType::OUT:
@@ -205,15 +219,17 @@ void Parser::synchronize(){
 }
 
 std::shared_ptr<Statement::Stmt> Parser::statement(){
-  if(match(TokenType::INCLUDE)) return includeStatement();
-  if(match(TokenType::OUTPUT)) return printStatement();
-  if(match(TokenType::OUT)) return outStatement();
-  if(match(TokenType::IF)) return IfStatement();
-  if(match(TokenType::RETURN)) return returnStatement();
-  if(match(TokenType::WHILE)) return whileStatement();
-  if(match(TokenType::FOR)) return forStatement();
-  if(match(TokenType::LEFT_BRACE)) return std::make_shared<Statement::Block>(block());
-  return expressionStatement();
+  const int line = peek().line;
+  if(match(TokenType::INCLUDE)) return at(includeStatement(), line);
+  if(match(TokenType::OUTPUT)) return at(printStatement(), line);
+  if(match(TokenType::OUT)) return at(outStatement(), line);
+  if(match(TokenType::IF)) return at(IfStatement(), line);
+  if(match(TokenType::RETURN)) return at(returnStatement(), line);
+  if(match(TokenType::YIELD)) return at(yieldStatement(), line);
+  if(match(TokenType::WHILE)) return at(whileStatement(), line);
+  if(match(TokenType::FOR)) return at(forStatement(), line);
+  if(match(TokenType::LEFT_BRACE)) return at(std::make_shared<Statement::Block>(block()), line);
+  return at(expressionStatement(), line);
 }
 
 std::shared_ptr<Statement::Stmt> Parser::printStatement(){
@@ -238,9 +254,17 @@ std::shared_ptr<Statement::Stmt> Parser::expressionStatement(){
 
 std::shared_ptr<Statement::Stmt> Parser::declaration(){
   try {
-    if(match(TokenType::SET)) return function("function");
-    if(match(TokenType::CLASS)) return classDeclaration();
-    if(match(TokenType::AUTO)) return varDeclaration();
+    const int line = peek().line;
+    if(match(TokenType::SET)) return at(function("function"), line);
+    if(match(TokenType::ASYNC)){
+      consume(TokenType::SET, "Expected 'set' after 'async'.");
+      std::shared_ptr<Statement::Function> fn = function("function");
+      if(fn->isGenerator) error(fn->name, "Can't yield from an async function.");
+      fn->isAsync = true;
+      return at(fn, line);
+    }
+    if(match(TokenType::CLASS)) return at(classDeclaration(), line);
+    if(match(TokenType::AUTO)) return at(varDeclaration(), line);
     return statement();
   } catch (const std::exception& e) {
     synchronize();
@@ -328,15 +352,23 @@ std::shared_ptr<Statement::Stmt> Parser::whileStatement(){
 }
 
 std::shared_ptr<Statement::Stmt> Parser::forStatement(){
+  const int line = previous().line;
   consume(TokenType::LEFT_PAREN, "Expected '(' after 'for'.");
 
+  // for (auto x in ...) or for (x in ...)
+  size_t name = static_cast<size_t>(current) + (check(TokenType::AUTO) ? 1 : 0);
+  if(name + 1 < tokens.size() && tokens[name].type == TokenType::IDENTIFIER &&
+      tokens[name + 1].type == TokenType::IN){
+    return forInStatement();
+  }
+
   std::shared_ptr<Statement::Stmt> init;
   if(match(TokenType::SEMICOLON)){
     init = nullptr;
   }else if(match(TokenType::AUTO)){
-    init = varDeclaration();
+    init = at(varDeclaration(), line);
   }else{
-    init = expressionStatement();
+    init = at(expressionStatement(), line);
   }
 
   std::shared_ptr<Expr> condition = nullptr;
@@ -353,17 +385,17 @@ std::shared_ptr<Statement::Stmt> Parser::forStatement(){
 
   std::shared_ptr<Statement::Stmt> body = statement();
   if(increment != nullptr){
-    body = std::make_shared<Statement::Block>(
+    body = at(std::make_shared<Statement::Block>(
         std::vector<std::shared_ptr<Statement::Stmt>> {
-        body, std::make_shared<Statement::Expression>(increment)
+        body, at(std::make_shared<Statement::Expression>(increment), line)
         } 
-        );
+        ), line);
   }
 
   if(condition == nullptr){
     condition = std::make_shared<Literal>(true);
   }
-  body = std::make_shared<Statement::While>(condition, body);
+  body = at(std::make_shared<Statement::While>(condition, body), line);
 
   if(init != nullptr){
     body = std::make_shared<Statement::Block>(
@@ -408,6 +440,24 @@ std::shared_ptr<Expr> Parser::finishCall(std::shared_ptr<Expr> callee){
   return std::make_shared<Call>(callee, paren, arguments);
 }
 
+std::shared_ptr<Statement::Stmt> Parser::forInStatement(){
+  matchVoid(TokenType::AUTO);
+  Token name = consume(TokenType::IDENTIFIER, "Expected variable name.");
+  consume(TokenType::IN, "Expected 'in' after variable name.");
+  std::shared_ptr<Expr> iterable = expression();
+  consume(TokenType::RIGHT_PAREN, "Expected ')' after for-in.");
+  std::shared_ptr<Statement::Stmt> body = statement();
+  return std::make_shared<Statement::ForIn>(std::move(name), std::move(iterable), std::move(body));
+}
+
+std::shared_ptr<Statement::Stmt> Parser::yieldStatement(){
+  Token keyword = previous();
+  std::shared_ptr<Expr> value = expression();
+  matchVoid(TokenType::SEMICOLON);
+  yielded = true;
+  return std::make_shared<Statement::Yield>(keyword, value);
+}
+
 std::shared_ptr<Statement::Stmt> Parser::returnStatement(){
   Token keyword = previous();
   std::shared_ptr<Expr> value = nullptr;
@@ -435,10 +485,15 @@ std::shared_ptr<Statement::Function> Parser::function(std::string kind){
   }
   consume(TokenType::RIGHT_PAREN, "Expected ')' after parameters.");
   consume(TokenType::LEFT_BRACE, "Expected '{' before " + kind + " body.");
+  bool enclosingYielded = yielded;
+  yielded = false;
   std::vector<std::shared_ptr<Statement::Stmt>> body = block();
-  return std::make_shared<Statement::Function>(
+  auto fn = std::make_shared<Statement::Function>(
       std::move(funcName), std::move(parameters), std::move(body)
       );
+  fn->isGenerator = yielded;
+  yielded = enclosingYielded;
+  return fn;
 }
 
 std::shared_ptr<Statement::Stmt> Parser::classDeclaration(){
@@ -447,7 +502,12 @@ std::shared_ptr<Statement::Stmt> Parser::classDeclaration(){
 
   std::vector<std::shared_ptr<Statement::Function>> methods;
   while(!check(TokenType::RIGHT_BRACE) && !isAtEnd()){
+    bool isAsync = match(TokenType::ASYNC);
     methods.push_back(function("method"));
+    if(isAsync && methods.back()->isGenerator){
+      error(methods.back()->name, "Can't yield from an async function.");
+    }
+    methods.back()->isAsync = isAsync;
   }
   consume(TokenType::RIGHT_BRACE, "Expected '}' after class body");
   return std::make_shared<Statement::Class>(name, std::move(methods));
@@ -466,11 +526,16 @@ std::shared_ptr<Statement::Stmt> Parser::includeStatement() {
   }
   includedFiles.push_back(path.lexeme);
 
-  IncludeRun::scanFile(path.lexeme);
-  const std::vector<Token>& tempTokens = IncludeRun::getTokens();
+  std::string includedFile = path.lexeme;
+  includedFile.erase(std::remove(includedFile.begin(), includedFile.end(), '\"'), includedFile.end());
+  std::vector<std::shared_ptr<Statement::Stmt>> includedStatements;
+  {
+    Tracer::Span span{"include", includedFile};
+    std::vector<Token> tempTokens = IncludeRun::scanFile(path.lexeme);
 
-  Parser includedParser(tempTokens);
-  std::vector<std::shared_ptr<Statement::Stmt>> includedStatements = includedParser.parse();
+    Parser includedParser(tempTokens, includedFile);
+    includedStatements = includedParser.parse();
+  }
 
   for (const auto& stmt : includedStatements) {
     statements.push_back(stmt);
@@ -18,6 +18,9 @@ class Parser {
     int current = 0;
     std::vector<std::shared_ptr<Statement::Stmt>> statements;
     std::vector<std::string> includedFiles;
+    std::shared_ptr<const std::string> file;
+    // Set by a yield, to make the function being parsed a generator
+    bool yielded = false;
 
     ParseError error(const Token&, const std::string&);
 
@@ -35,6 +38,7 @@ class Parser {
     Token peek();
     Token advance();
     Token consume(const TokenType&, const std::string&);
+    std::shared_ptr<Statement::Stmt> at(std::shared_ptr<Statement::Stmt> stmt, int line);
 
     std::shared_ptr<Expr> expression();
     std::shared_ptr<Expr> bitwise();
@@ -64,13 +68,15 @@ class Parser {
     std::shared_ptr<Statement::Stmt> IfStatement();
     std::shared_ptr<Statement::Stmt> whileStatement();
     std::shared_ptr<Statement::Stmt> forStatement();
+    std::shared_ptr<Statement::Stmt> forInStatement();
     std::shared_ptr<Statement::Stmt> returnStatement();
+    std::shared_ptr<Statement::Stmt> yieldStatement();
     std::shared_ptr<Statement::Stmt> classDeclaration();
     std::shared_ptr<Statement::Stmt> includeStatement();
 
     std::shared_ptr<Statement::Function> function(std::string kind);
 
   public:
-    Parser(const std::vector<Token>&);
+    Parser(const std::vector<Token>&, const std::string& file = "");
     std::vector<std::shared_ptr<Statement::Stmt>> parse();
 };
@@ -79,4 +79,18 @@ namespace Statement {
   std::any Include::accept(StmtVisitor &visitor){
     return visitor.visitIncludeStmt(shared_from_this());
   }
+
+  Yield::Yield(Token keyword, std::shared_ptr<Expr> value) :
+    keyword{std::move(keyword)}, value{std::move(value)} {}
+
+  std::any Yield::accept(StmtVisitor &visitor){
+    return visitor.visitYieldStmt(shared_from_this());
+  }
+
+  ForIn::ForIn(Token name, std::shared_ptr<Expr> iterable, std::shared_ptr<Stmt> body) :
+    name{std::move(name)}, iterable{std::move(iterable)}, body{std::move(body)} {}
+
+  std::any ForIn::accept(StmtVisitor &visitor){
+    return visitor.visitForInStmt(shared_from_this());
+  }
 }
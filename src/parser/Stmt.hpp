@@ -71,6 +71,10 @@ namespace Statement {
     Token name;
     std::vector<Token> params;
     std::vector<std::shared_ptr<Stmt>> body;
+    // Declared with `async set`: calls return a promise, see EventLoop
+    bool isAsync = false;
+    // Contains a yield: calls return a generator, see Generator
+    bool isGenerator = false;
     Function(Token name, std::vector<Token> params, std::vector<std::shared_ptr<Stmt>> body);
     std::any accept(StmtVisitor &visitor) override;
     ~Function() = default;
@@ -101,5 +105,23 @@ namespace Statement {
     ~Include() = default;
   };
 
+  struct Yield final: Stmt, public std::enable_shared_from_this<Yield> {
+    Token keyword;
+    std::shared_ptr<Expr> value;
+
+    Yield(Token keyword, std::shared_ptr<Expr> value);
+    std::any accept(StmtVisitor& visitor) override;
+  };
+
+  // for (x in iterable) body: x is a new variable scoped to the loop
+  struct ForIn final: Stmt, public std::enable_shared_from_this<ForIn> {
+    Token name;
+    std::shared_ptr<Expr> iterable;
+    std::shared_ptr<Stmt> body;
+
+    ForIn(Token name, std::shared_ptr<Expr> iterable, std::shared_ptr<Stmt> body);
+    std::any accept(StmtVisitor& visitor) override;
+  };
+
 }
 
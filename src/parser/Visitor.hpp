@@ -1,7 +1,11 @@
 #pragma once
 
 #include <any>
+#include <cstdint>
 #include <memory>
+#include <string>
+
+#include "../utils/Stats.hpp"
 
 struct Binary;
 struct Grouping;
@@ -33,6 +37,7 @@ struct ExprVisitor {
 };
 
 struct Expr {
+  Expr(){ ++Stats::get().nodes; }
   virtual std::any accept(ExprVisitor &visitor) = 0;
 };
 
@@ -49,6 +54,8 @@ namespace Statement {
   struct Return;
   struct Class;
   struct Include;
+  struct Yield;
+  struct ForIn;
 
   struct StmtVisitor {
     virtual std::any visitExpressionStmt(std::shared_ptr<Expression> stmt) = 0;
@@ -62,10 +69,21 @@ namespace Statement {
     virtual std::any visitReturnStmt(std::shared_ptr<Return> stmt) = 0;
     virtual std::any visitClassStmt(std::shared_ptr<Class> stmt) = 0;
     virtual std::any visitIncludeStmt(std::shared_ptr<Include> stmt) = 0;
+    virtual std::any visitYieldStmt(std::shared_ptr<Yield> stmt) = 0;
+    virtual std::any visitForInStmt(std::shared_ptr<ForIn> stmt) = 0;
     virtual ~StmtVisitor() = default;
   };
 
   struct Stmt {
+    // Where the statement starts, stamped by the parser
+    int line = 0;
+    std::shared_ptr<const std::string> file;
+
+    // Filled while `ter --line-profile` is attached
+    uint64_t hits = 0;
+    int64_t selfNs = 0;
+
+    Stmt(){ ++Stats::get().nodes; }
     virtual std::any accept(StmtVisitor& visitor) = 0;
   };
 }
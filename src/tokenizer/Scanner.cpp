@@ -1,5 +1,6 @@
 #include "Scanner.hpp"
 #include "../utils/Debug.hpp"
+#include "../interpreter/StringType.hpp"
 
 Scanner::Scanner(const std::string& source) : source(source) {}
 
@@ -59,8 +60,23 @@ void Scanner::string(){
 
   advance();
 
-  std::string value{source.substr(static_cast<size_t>(start + 1), static_cast<size_t>(current - start - 2))};
-  addToken(TokenType::STRING, value);
+  std::string_view value{source.data() + start + 1, static_cast<size_t>(current - start - 2)};
+  if(value.find('\\') == std::string_view::npos){
+    addToken(TokenType::STRING, StringType::intern(value));
+    return;
+  }
+
+  // Escapes are resolved once here rather than on every print
+  std::string unescaped;
+  unescaped.reserve(value.length());
+  for(size_t i = 0; i < value.length(); ++i){
+    if(value[i] == '\\' && i + 1 < value.length()){
+      if(value[i + 1] == 'n'){ unescaped.push_back('\n'); ++i; continue; }
+      if(value[i + 1] == 'r'){ unescaped.push_back('\r'); ++i; continue; }
+    }
+    unescaped.push_back(value[i]);
+  }
+  addToken(TokenType::STRING, StringType::intern(unescaped));
 }
 
 bool Scanner::match(char expected){
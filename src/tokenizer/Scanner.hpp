@@ -29,7 +29,10 @@ class Scanner {
       {"this",   TokenType::THIS},
       {"true",   TokenType::TRUE},
       {"auto",    TokenType::AUTO},
-      {"while",  TokenType::WHILE}
+      {"while",  TokenType::WHILE},
+      {"async",  TokenType::ASYNC},
+      {"yield",  TokenType::YIELD},
+      {"in",     TokenType::IN}
     };
 
     bool isAlpha(char c);
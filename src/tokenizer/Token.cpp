@@ -1,5 +1,6 @@
 #include "Token.hpp"
 #include <sstream>
+#include "../interpreter/StringType.hpp"
 
 Token::Token(TokenType type, std::string lexeme, std::any literal, int line) : 
   type(type), lexeme(lexeme), literal(literal), line(line) {}
@@ -9,8 +10,8 @@ std::string Token::toString(){
   if(literal.has_value()){
     const std::type_info& type_any = literal.type();
 
-    if(type_any == typeid(std::string)){
-      ss_literal << std::any_cast<std::string>(literal);
+    if(type_any == typeid(std::shared_ptr<StringType>)){
+      ss_literal << std::any_cast<std::shared_ptr<StringType>>(literal)->str();
     }else if(type_any == typeid(int)){
       ss_literal << std::any_cast<int>(literal);
     }else if(type_any == typeid(double)){
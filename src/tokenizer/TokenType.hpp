@@ -11,7 +11,7 @@ enum class TokenType {
   IDENTIFIER, STRING, NUMBER, INCLUDE,
 
   AND, CLASS, ELSE, FALSE, SET, FOR, IF, NIL, OR, OUT,
-  OUTPUT, RETURN, SUPER, THIS, TRUE, AUTO, WHILE,
+  OUTPUT, RETURN, SUPER, THIS, TRUE, AUTO, WHILE, ASYNC, YIELD, IN,
 
   TER_EOF 
 };
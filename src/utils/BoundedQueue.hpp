@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <new>
+
+/* Bounded lock-free multi-producer multi-consumer queue (Dmitry Vyukov's
+   array queue). Every cell carries a sequence number telling producers and
+   consumers whose turn it is, so a push or pop is one CAS on a shared index
+   plus a store to the cell, and never waits on another thread. Push fails
+   when full and pop when empty; blocking is left to the caller. The ring
+   is rounded up to a power of two, at least 2 cells, but a push is refused
+   once the requested capacity is in use, so it never holds more. */
+template <typename T>
+class BoundedQueue {
+  public:
+    explicit BoundedQueue(size_t capacity) :
+      limit{capacity < 1 ? size_t{1} : capacity},
+      mask{std::bit_ceil(capacity < 2 ? size_t{2} : capacity) - 1},
+      cells{std::make_unique<Cell[]>(mask + 1)} {
+      for(size_t i = 0; i <= mask; ++i){
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+      }
+    }
+
+    size_t capacity() const {
+      return limit;
+    }
+
+    bool push(T& value){
+      Cell* cell;
+      size_t position = tail.load(std::memory_order_relaxed);
+      for(;;){
+        cell = &cells[position & mask];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+        if(difference == 0){
+          // A stale head only refuses early; the caller retries after a pop
+          if(position - head.load(std::memory_order_acquire) >= limit) return false;
+          if(tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+        }else if(difference < 0){
+          return false;
+        }else{
+          position = tail.load(std::memory_order_relaxed);
+        }
+      }
+      cell->value = std::move(value);
+      cell->sequence.store(position + 1, std::memory_order_release);
+      return true;
+    }
+
+    bool pop(T& value){
+      Cell* cell;
+      size_t position = head.load(std::memory_order_relaxed);
+      for(;;){
+        cell = &cells[position & mask];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+        if(difference == 0){
+          if(head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+        }else if(difference < 0){
+          return false;
+        }else{
+          position = head.load(std::memory_order_relaxed);
+        }
+      }
+      value = std::move(cell->value);
+      cell->value = T{};
+      cell->sequence.store(position + mask + 1, std::memory_order_release);
+      return true;
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    void operator=(const BoundedQueue&) = delete;
+
+  private:
+    static constexpr size_t lineSize = 64;
+
+    struct Cell {
+      std::atomic<size_t> sequence;
+      T value;
+    };
+
+    const size_t limit;
+    const size_t mask;
+    std::unique_ptr<Cell[]> cells;
+    // Producers and consumers each hammer one index: keep them apart
+    alignas(lineSize) std::atomic<size_t> tail{0};
+    alignas(lineSize) std::atomic<size_t> head{0};
+};
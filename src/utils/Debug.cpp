@@ -1,10 +1,16 @@
 #include "Debug.hpp"
-#include <iostream>
+#include "../interpreter/Isolate.hpp"
+
+Debug& Debug::get_instance(){
+  return Isolate::current().debug;
+}
 
 void Debug::report(int line, const std::string& where, const std::string& message){
-  hadError = true;
-  //std::cerr << "[" + Debug::filename + "] " << "error: line: " << line << where << ": " << message << '\n';
-  std::cerr << "error: line: " << line << where << ": " << message << '\n';
+  Isolate& isolate = Isolate::current();
+  isolate.debug.hadError = true;
+  isolate.output.flush();
+  //isolate.errors << "[" + isolate.debug.filename + "] " << "error: line: " << line << where << ": " << message << '\n';
+  isolate.errors << "error: line: " << line << where << ": " << message << '\n';
 } 
 
 void Debug::error(int line, const std::string& message){
@@ -20,6 +26,8 @@ void Debug::error(Token token, const std::string& message){
 }
 
 void Debug::runtimeError(const RuntimeError& error){
-  //std::cerr << "[" + Debug::filename + "] " << "[line " << error.token.line << "] Error: " << error.what() << '\n';
-  std::cerr << "[line " << error.token.line << "] Error: " << error.what() << '\n';
+  Isolate& isolate = Isolate::current();
+  isolate.output.flush();
+  //isolate.errors << "[" + isolate.debug.filename + "] " << "[line " << error.token.line << "] Error: " << error.what() << '\n';
+  isolate.errors << "[line " << error.token.line << "] Error: " << error.what() << '\n';
 }
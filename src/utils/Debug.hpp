@@ -3,14 +3,17 @@
 #include "../tokenizer/Token.hpp"
 #include "RuntimeError.hpp"
 
+// Error flags of the current isolate; reports go to its error stream
 class Debug {
   private:
     static void report(int, const std::string&, const std::string&);
 
   public:
-    inline static std::string filename;
-    inline static bool hadError = false;
-    inline static bool hadRuntimeError = false;
+    std::string filename;
+    bool hadError = false;
+    bool hadRuntimeError = false;
+
+    static Debug& get_instance();
     static void error(int line, const std::string&);
     static void error(Token token, const std::string&);
     static void runtimeError(const RuntimeError& error);
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/* Environments, arrays and instances are stamped with the epoch they were
+   created in. Every parallel section starts a new epoch, so its workers can
+   tell what they created themselves (writable) from what existed before
+   the section (shared with other workers, read-only). */
+struct Epoch {
+  inline static std::atomic<uint64_t> counter{0};
+
+  static uint64_t now(){
+    return counter.load(std::memory_order_relaxed);
+  }
+
+  // Starts an epoch; objects created from now on have a stamp >= the result
+  static uint64_t next(){
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+};
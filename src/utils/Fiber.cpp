@@ -0,0 +1,145 @@
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <new>
+#include <vector>
+
+#include "Fiber.hpp"
+
+#if defined(__SANITIZE_THREAD__)
+extern "C" {
+  void* __tsan_get_current_fiber();
+  void* __tsan_create_fiber(unsigned flags);
+  void __tsan_destroy_fiber(void* fiber);
+  void __tsan_switch_to_fiber(void* fiber, unsigned flags);
+}
+#endif
+
+namespace {
+  // As deep as the main thread's default stack; only touched pages count
+  constexpr size_t stackSize = size_t{8} << 20;
+  // Stacks kept for reuse by each thread
+  constexpr size_t cachedStacks = 16;
+
+  size_t guardSize(){
+    static const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return page;
+  }
+
+  struct StackCache {
+    std::vector<void*> stacks;
+
+    ~StackCache(){
+      for(void* stack : stacks){
+        munmap(static_cast<char*>(stack) - guardSize(), stackSize + guardSize());
+      }
+    }
+  };
+
+  thread_local StackCache cache;
+
+  void* allocateStack(){
+    if(!cache.stacks.empty()){
+      void* stack = cache.stacks.back();
+      cache.stacks.pop_back();
+      return stack;
+    }
+    void* memory = mmap(nullptr, stackSize + guardSize(), PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if(memory == MAP_FAILED) throw std::bad_alloc{};
+    mprotect(memory, guardSize(), PROT_NONE);
+    return static_cast<char*>(memory) + guardSize();
+  }
+
+  void releaseStack(void* stack){
+    if(cache.stacks.size() < cachedStacks){
+      cache.stacks.push_back(stack);
+      return;
+    }
+    munmap(static_cast<char*>(stack) - guardSize(), stackSize + guardSize());
+  }
+
+  void* currentSanitizerFiber(){
+#if defined(__SANITIZE_THREAD__)
+    return __tsan_get_current_fiber();
+#else
+    return nullptr;
+#endif
+  }
+
+  void switchSanitizerFiber([[maybe_unused]] void* fiber){
+#if defined(__SANITIZE_THREAD__)
+    __tsan_switch_to_fiber(fiber, 0);
+#endif
+  }
+}
+
+Fiber::Fiber(std::function<void()> function) : body{std::move(function)}, stack{allocateStack()} {
+  getcontext(&context);
+  context.uc_stack.ss_sp = stack;
+  context.uc_stack.ss_size = stackSize;
+  context.uc_link = nullptr;
+  makecontext(&context, &Fiber::entry, 0);
+#if defined(__SANITIZE_THREAD__)
+  sanitizerFiber = __tsan_create_fiber(0);
+#endif
+}
+
+Fiber::~Fiber(){
+  if(!done){
+    cancelling = true;
+    try{
+      resume();
+    }catch(...){
+    }
+  }
+#if defined(__SANITIZE_THREAD__)
+  __tsan_destroy_fiber(sanitizerFiber);
+#endif
+  releaseStack(stack);
+}
+
+void Fiber::resume(){
+  resumer = running;
+  running = this;
+  callerSanitizerFiber = currentSanitizerFiber();
+  switchSanitizerFiber(sanitizerFiber);
+  swapcontext(&caller, &context);
+  running = resumer;
+  if(error){
+    std::exception_ptr raised = std::move(error);
+    error = nullptr;
+    std::rethrow_exception(raised);
+  }
+}
+
+bool Fiber::finished() const {
+  return done;
+}
+
+void Fiber::suspend(){
+  Fiber* fiber = running;
+  switchSanitizerFiber(fiber->callerSanitizerFiber);
+  swapcontext(&fiber->context, &fiber->caller);
+  if(fiber->cancelling) throw Cancelled{};
+}
+
+Fiber* Fiber::current(){
+  return running;
+}
+
+void Fiber::entry(){
+  Fiber* fiber = running;
+  if(!fiber->cancelling){
+    try{
+      fiber->body();
+    }catch(const Cancelled&){
+    }catch(...){
+      fiber->error = std::current_exception();
+    }
+  }
+  fiber->done = true;
+  // Never resumed again: the resumer frees the stack this runs on
+  switchSanitizerFiber(fiber->callerSanitizerFiber);
+  setcontext(&fiber->caller);
+}
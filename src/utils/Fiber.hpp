@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+
+#include <ucontext.h>
+
+/* Stackful coroutine: runs a function on a stack of its own and can stop
+   anywhere in it, however deep, to continue later exactly there. resume()
+   runs the fiber until it calls suspend() or returns; an exception it
+   does not catch is raised in resume(). A fiber destroyed while suspended
+   is unwound first: its suspend() throws Cancelled, so destructors on its
+   stack run.
+
+   Stacks are mapped lazily with a guard page below them, so a deep
+   recursion faults instead of overwriting memory, and only pages that
+   were touched cost memory. Freed stacks are kept for the next fiber. */
+class Fiber {
+  public:
+    // Thrown by suspend() in a fiber that is being destroyed
+    struct Cancelled {};
+
+    explicit Fiber(std::function<void()> body);
+    ~Fiber();
+
+    void resume();
+    bool finished() const;
+
+    // Back to the resume() that runs the current fiber
+    static void suspend();
+    // The fiber running on this thread, or null outside of any
+    static Fiber* current();
+
+    Fiber(const Fiber&) = delete;
+    void operator=(const Fiber&) = delete;
+
+  private:
+    std::function<void()> body;
+    ucontext_t context;
+    ucontext_t caller;
+    void* stack;
+    Fiber* resumer = nullptr;
+    bool done = false;
+    bool cancelling = false;
+    std::exception_ptr error;
+    // ThreadSanitizer's view of the two stacks, in sanitized builds
+    void* sanitizerFiber = nullptr;
+    void* callerSanitizerFiber = nullptr;
+
+    inline static thread_local Fiber* running = nullptr;
+
+    static void entry();
+};
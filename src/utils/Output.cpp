@@ -0,0 +1,107 @@
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#define isatty _isatty
+#define fileno _fileno
+#else
+#include <unistd.h>
+#endif
+
+#include "Output.hpp"
+#include "../interpreter/Isolate.hpp"
+
+namespace {
+  constexpr size_t outputBufferSize = 1 << 16;
+}
+
+// A string is a buffer already: captured output is appended to it directly
+Output::Output(std::string* sink) : buffer(sink == nullptr ? outputBufferSize : 0), capture{sink} {
+  lineBuffered = capture == nullptr && isatty(fileno(stdout)) != 0;
+}
+
+Output& Output::get_instance(){
+  return Isolate::current().output;
+}
+
+bool Output::captures() const {
+  return capture != nullptr;
+}
+
+Output::~Output(){
+  flush();
+}
+
+void Output::write(std::string_view text){
+  if(capture != nullptr){
+    capture->append(text);
+    return;
+  }
+  if(text.size() > buffer.size() - used){
+    flush();
+    if(text.size() >= buffer.size()){
+      std::fwrite(text.data(), 1, text.size(), stdout);
+      std::fflush(stdout);
+      return;
+    }
+  }
+  std::memcpy(buffer.data() + used, text.data(), text.size());
+  used += text.size();
+
+  if(lineBuffered && std::memchr(text.data(), '\n', text.size()) != nullptr){
+    flush();
+  }
+}
+
+void Output::put(char c){
+  if(capture != nullptr){
+    capture->push_back(c);
+    return;
+  }
+  if(used == buffer.size()){
+    flush();
+  }
+  buffer[used++] = c;
+  if(lineBuffered && c == '\n'){
+    flush();
+  }
+}
+
+void Output::writeNumber(double value){
+  char out[numberBufferSize];
+  write(formatNumber(value, out));
+}
+
+void Output::flush(){
+  if(capture != nullptr) return;
+  if(used != 0){
+    std::fwrite(buffer.data(), 1, used, stdout);
+    used = 0;
+  }
+  std::fflush(stdout);
+}
+
+std::string_view Output::formatNumber(double value, char (&out)[numberBufferSize]){
+  char* end = out + numberBufferSize;
+
+  // Integral values are by far the most common: print them as integers,
+  // keeping "-0" as the fixed notation would. The sign is read from the bits
+  // because -ffast-math lets the compiler ignore the sign of zero.
+  bool negativeZero = std::bit_cast<uint64_t>(value) == (uint64_t{1} << 63);
+  if(std::fabs(value) < 1e15 && value == std::trunc(value) && !negativeZero){
+    auto result = std::to_chars(out, end, static_cast<int64_t>(value));
+    return {out, static_cast<size_t>(result.ptr - out)};
+  }
+
+  auto result = std::to_chars(out, end, value, std::chars_format::fixed, 6);
+  std::string_view text{out, static_cast<size_t>(result.ptr - out)};
+  if(text.size() > 7 && text.substr(text.size() - 7) == ".000000"){
+    text.remove_suffix(7);
+  }
+  return text;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* Buffered writer for everything a script prints. Output is collected in a
+   large buffer and written in big chunks; it is flushed when full, before
+   reading input, before running a child process, before reporting errors
+   and at exit. When stdout is a terminal every line is flushed. Each
+   isolate owns one, which may capture into a string instead of stdout;
+   captured output goes straight into the string. */
+class Output {
+  private:
+    std::vector<char> buffer;
+    size_t used = 0;
+    bool lineBuffered = false;
+    std::string* capture;
+
+  public:
+    // Enough for any double in fixed notation with six decimals
+    static constexpr size_t numberBufferSize = 512;
+
+    explicit Output(std::string* sink = nullptr);
+
+    // Output of the current isolate
+    static Output& get_instance();
+
+    void write(std::string_view text);
+    void put(char c);
+    void writeNumber(double value);
+    void flush();
+    // True when writing to a string rather than stdout
+    bool captures() const;
+
+    // Formats like "%f" without the ".000000" of integral values
+    static std::string_view formatNumber(double value, char (&out)[numberBufferSize]);
+
+    ~Output();
+    Output(const Output&) = delete;
+    void operator=(const Output&) = delete;
+};
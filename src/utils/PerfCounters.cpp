@@ -0,0 +1,103 @@
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "PerfCounters.hpp"
+
+PerfCounters::Sample PerfCounters::Sample::operator-(const Sample& other) const {
+  return {instructions - other.instructions, cycles - other.cycles,
+    branchMisses - other.branchMisses, cacheMisses - other.cacheMisses};
+}
+
+PerfCounters::Sample& PerfCounters::Sample::operator+=(const Sample& other){
+  instructions += other.instructions;
+  cycles += other.cycles;
+  branchMisses += other.branchMisses;
+  cacheMisses += other.cacheMisses;
+  return *this;
+}
+
+double PerfCounters::Sample::ipc() const {
+  return cycles == 0 ? 0.0 : static_cast<double>(instructions) / static_cast<double>(cycles);
+}
+
+void PerfCounters::open(){
+  if(enabled) return;
+
+#ifdef __linux__
+  const uint64_t configs[count] = {
+    PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES
+  };
+
+  for(int i = 0; i < count; ++i){
+    struct perf_event_attr attr{};
+    attr.size = sizeof attr;
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = configs[i];
+    attr.disabled = i == 0 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+
+    long fd = syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : fds[0], 0);
+    if(fd < 0){
+      std::cerr << "Hardware counters unavailable: " << std::strerror(errno) << ".\n";
+      for(int j = 0; j < i; ++j){
+        close(fds[j]);
+        fds[j] = -1;
+      }
+      return;
+    }
+    fds[i] = static_cast<int>(fd);
+  }
+
+  ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  enabled = true;
+#else
+  std::cerr << "Hardware counters unavailable: perf_event_open is Linux only.\n";
+#endif
+}
+
+PerfCounters::Sample PerfCounters::read(){
+  Sample sample;
+#ifdef __linux__
+  if(!enabled) return sample;
+
+  // PERF_FORMAT_GROUP: the number of events, then one value per event
+  uint64_t values[1 + count] = {};
+  if(::read(fds[0], values, sizeof values) != static_cast<ssize_t>(sizeof values)){
+    return sample;
+  }
+  sample.instructions = values[1];
+  sample.cycles = values[2];
+  sample.branchMisses = values[3];
+  sample.cacheMisses = values[4];
+#endif
+  return sample;
+}
+
+void PerfCounters::print(std::ostream& out, const Sample& sample){
+  out << sample.instructions << " instructions, "
+    << sample.cycles << " cycles, IPC "
+    << std::fixed << std::setprecision(2) << sample.ipc() << ", "
+    << sample.branchMisses << " branch misses, "
+    << sample.cacheMisses << " cache misses";
+}
+
+PerfCounters::~PerfCounters(){
+#ifdef __linux__
+  for(int fd : fds){
+    if(fd >= 0) close(fd);
+  }
+#endif
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+/* Hardware counters read through perf_event_open, enabled with `ter --perf`.
+   --stats, --profile and bench() add them to their reports. Counters are
+   opened for the main thread and user space only; when the kernel, the
+   permissions or the machine do not provide them, enabled stays false and
+   the reports stay as they are. */
+class PerfCounters {
+  public:
+    struct Sample {
+      uint64_t instructions = 0;
+      uint64_t cycles = 0;
+      uint64_t branchMisses = 0;
+      uint64_t cacheMisses = 0;
+
+      Sample operator-(const Sample& other) const;
+      Sample& operator+=(const Sample& other);
+      double ipc() const;
+    };
+
+    inline static bool enabled = false;
+
+    static PerfCounters& get_instance() {
+      static PerfCounters instance;
+      return instance;
+    }
+
+    // Sets enabled when the counters could be opened; otherwise says why
+    void open();
+    Sample read();
+
+    static void print(std::ostream& out, const Sample& sample);
+
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    void operator=(const PerfCounters&) = delete;
+
+  private:
+    static constexpr int count = 4;
+    int fds[count] = {-1, -1, -1, -1};
+
+    PerfCounters() = default;
+};
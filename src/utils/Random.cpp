@@ -0,0 +1,70 @@
+#include <atomic>
+#include <random>
+#include <utility>
+
+#include "Random.hpp"
+
+namespace {
+  uint64_t rotl(uint64_t x, int k){
+    return (x << k) | (x >> (64 - k));
+  }
+
+  uint64_t splitmix64(uint64_t& x){
+    uint64_t z = (x += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+  }
+}
+
+Random::Random(){
+  // Opening the system source costs microseconds, more than a whole
+  // spawned task: read it once and give every generator its own offset
+  static const uint64_t base = []{
+    std::random_device rd;
+    return (static_cast<uint64_t>(rd()) << 32) | rd();
+  }();
+  static std::atomic<uint64_t> created{0};
+  seed(base + created.fetch_add(1, std::memory_order_relaxed));
+}
+
+void Random::seed(uint64_t value){
+  // splitmix64 spreads any seed, including 0, over the whole state
+  for(uint64_t& word : state){
+    word = splitmix64(value);
+  }
+}
+
+uint64_t Random::next(){
+  const uint64_t result = rotl(state[1] * 5, 7) * 9;
+  const uint64_t t = state[1] << 17;
+  state[2] ^= state[0];
+  state[3] ^= state[1];
+  state[1] ^= state[2];
+  state[0] ^= state[3];
+  state[2] ^= t;
+  state[3] = rotl(state[3], 45);
+  return result;
+}
+
+double Random::nextDouble(){
+  return static_cast<double>(next() >> 11) * 0x1.0p-53;
+}
+
+int64_t Random::nextInt(int64_t low, int64_t high){
+  if(high < low){
+    std::swap(low, high);
+  }
+  const uint64_t range = static_cast<uint64_t>(high) - static_cast<uint64_t>(low) + 1;
+  if(range == 0){
+    return static_cast<int64_t>(next());
+  }
+
+  // Reject the few low values that would bias the modulo
+  const uint64_t threshold = (0 - range) % range;
+  uint64_t value = next();
+  while(value < threshold){
+    value = next();
+  }
+  return static_cast<int64_t>(static_cast<uint64_t>(low) + value % range);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+/* xoshiro256** generator owned by each interpreter. Seeded from the system
+   at startup, or explicitly through seed() for reproducible runs. */
+class Random {
+  private:
+    uint64_t state[4];
+
+  public:
+    Random();
+    void seed(uint64_t value);
+    uint64_t next();
+    // Uniform double in [0, 1)
+    double nextDouble();
+    // Uniform integer in [low, high], both inclusive
+    int64_t nextInt(int64_t low, int64_t high);
+};
@@ -1,4 +1,7 @@
 #include "RuntimeError.hpp"
+#include "Stats.hpp"
 
 RuntimeError::RuntimeError(const Token& token, const std::string& message) :
-   std::runtime_error{message}, token{token} {}
+   std::runtime_error{message}, token{token} {
+  ++Stats::get().exceptions;
+}
@@ -0,0 +1,60 @@
+#include <iomanip>
+#include <ostream>
+#include <utility>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "Stats.hpp"
+
+int64_t Stats::elapsedRunNs(){
+  const Counters& counters = get();
+  if(counters.runStart == clock::time_point{}) return counters.runNs;
+  return counters.runNs +
+    std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - counters.runStart).count();
+}
+
+uint64_t Stats::peakRssBytes(){
+#ifndef _WIN32
+  struct rusage usage{};
+  if(getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+  uint64_t peak = static_cast<uint64_t>(usage.ru_maxrss);
+#ifdef __APPLE__
+  return peak;
+#else
+  // Linux and the BSDs report kilobytes
+  return peak * 1024;
+#endif
+#else
+  return 0;
+#endif
+}
+
+void Stats::report(std::ostream& out){
+  auto ms = [](int64_t ns){ return static_cast<double>(ns) / 1e6; };
+  const Counters& c = get();
+
+  out << "\nStats\n" << std::fixed << std::setprecision(3);
+  out << "  scan        " << std::setw(12) << ms(c.scanNs) << " ms  " << c.tokens << " tokens\n";
+  out << "  parse       " << std::setw(12) << ms(c.parseNs) << " ms  " << c.nodes << " AST nodes\n";
+  out << "  resolve     " << std::setw(12) << ms(c.resolveNs) << " ms\n";
+  out << "  run         " << std::setw(12) << ms(elapsedRunNs()) << " ms\n";
+  out << "  peak RSS    " << std::setw(12) << static_cast<double>(peakRssBytes()) / (1024.0 * 1024.0) << " MiB\n";
+  out << "  calls       " << std::setw(12) << c.calls << '\n';
+  out << "  exceptions  " << std::setw(12) << c.exceptions << '\n';
+  out << "  allocations " << std::setw(12) << allocations()
+    << "  env " << c.environments << ", instance " << c.instances
+    << ", array " << c.arrays << ", string " << c.strings << '\n';
+
+  if(PerfCounters::enabled){
+    const std::pair<const char*, PerfCounters::Sample> phases[] = {
+      {"scan", c.scanPerf}, {"parse", c.parsePerf}, {"resolve", c.resolvePerf}, {"run", c.runPerf}
+    };
+    for(const auto& [name, sample] : phases){
+      out << "  " << std::left << std::setw(10) << name << std::right;
+      PerfCounters::print(out, sample);
+      out << '\n';
+    }
+  }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+
+#include "PerfCounters.hpp"
+
+/* Runtime counters behind `ter --stats` and the stats() builtin. Every
+   isolate has its own, made current on the thread by Isolate::Scope, so
+   hot paths increment without contention and isolates sharing a thread
+   (tasks, parallel items, C API users) do not mix their counts. Code
+   outside any isolate counts into a fallback of the thread. Phase times
+   are added by Ter::run. */
+struct Stats {
+  using clock = std::chrono::steady_clock;
+
+  struct Counters {
+    uint64_t environments = 0;
+    uint64_t instances = 0;
+    uint64_t arrays = 0;
+    uint64_t strings = 0;
+    uint64_t calls = 0;
+    uint64_t exceptions = 0;
+    uint64_t nodes = 0;
+
+    uint64_t tokens = 0;
+    int64_t scanNs = 0;
+    int64_t parseNs = 0;
+    int64_t resolveNs = 0;
+    int64_t runNs = 0;
+    clock::time_point runStart{};
+
+    // Hardware counters per phase, with `--perf`
+    PerfCounters::Sample scanPerf, parsePerf, resolvePerf, runPerf;
+  };
+
+  inline static thread_local Counters* active = nullptr;
+
+  // Counters of the isolate current on this thread
+  static Counters& get(){
+    if(active != nullptr) return *active;
+    thread_local Counters fallback;
+    return fallback;
+  }
+
+  // Adds the lifetime of the scope to one of the phase totals
+  class Phase {
+    public:
+      Phase(int64_t& phaseTotal, PerfCounters::Sample& phasePerf) :
+        total{phaseTotal}, perf{phasePerf}, perfStart{readPerf()}, start{clock::now()} {}
+      ~Phase(){
+        total += std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+        perf += readPerf() - perfStart;
+      }
+
+    private:
+      int64_t& total;
+      PerfCounters::Sample& perf;
+      PerfCounters::Sample perfStart;
+      clock::time_point start;
+  };
+
+  static PerfCounters::Sample readPerf(){
+    return PerfCounters::enabled ? PerfCounters::get_instance().read() : PerfCounters::Sample{};
+  }
+
+  // Ter objects (strings, arrays, instances, environments) created so far
+  static uint64_t allocations(){
+    const Counters& counters = get();
+    return counters.environments + counters.instances + counters.arrays + counters.strings;
+  }
+
+  // Run time so far, including the script that is still running
+  static int64_t elapsedRunNs();
+  static uint64_t peakRssBytes();
+  static void report(std::ostream& out);
+};
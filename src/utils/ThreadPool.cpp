@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <cstdlib>
+
+#include "ThreadPool.hpp"
+#include "../interpreter/Sampler.hpp"
+
+ThreadPool::ThreadPool(){
+  size_t threads = std::thread::hardware_concurrency();
+  if(const char* env = std::getenv("TER_THREADS")){
+    threads = static_cast<size_t>(std::max(1L, std::atol(env)));
+  }
+  size_t count = threads > 1 ? threads - 1 : 0;
+
+  for(size_t i = 0; i <= count; ++i){
+    queues.push_back(std::make_unique<Queue>());
+  }
+  for(size_t i = 0; i < count; ++i){
+    workers.emplace_back([this, i]{ work(i); });
+  }
+}
+
+ThreadPool::~ThreadPool(){
+  {
+    std::lock_guard<std::mutex> guard(sleepLock);
+    stopping = true;
+  }
+  wake.notify_all();
+  for(std::thread& worker : workers){
+    worker.join();
+  }
+}
+
+size_t ThreadPool::concurrency() const {
+  return workers.size() + 1;
+}
+
+void ThreadPool::submit(Task task){
+  Queue* queue = own;
+  if(queue == nullptr){
+    // Spread tasks from outside so every worker starts with local work
+    queue = queues[nextQueue++ % queues.size()].get();
+  }
+  {
+    std::lock_guard<std::mutex> guard(queue->lock);
+    queue->tasks.push_back(std::move(task));
+  }
+  ++pending;
+  // Taking the lock orders the notification after a worker's check of pending
+  { std::lock_guard<std::mutex> guard(sleepLock); }
+  wake.notify_one();
+}
+
+bool ThreadPool::runOne(){
+  if(pending.load() == 0) return false;
+  Task task;
+
+  // Newest own task first: it is the most likely to be in cache
+  if(own != nullptr){
+    std::lock_guard<std::mutex> guard(own->lock);
+    if(!own->tasks.empty()){
+      task = std::move(own->tasks.back());
+      own->tasks.pop_back();
+    }
+  }
+
+  // Otherwise steal the oldest task of another queue: usually the biggest
+  if(!task){
+    size_t start = nextQueue.load();
+    for(size_t i = 0; i < queues.size() && !task; ++i){
+      Queue* victim = queues[(start + i) % queues.size()].get();
+      if(victim == own) continue;
+      std::lock_guard<std::mutex> guard(victim->lock);
+      if(!victim->tasks.empty()){
+        task = std::move(victim->tasks.front());
+        victim->tasks.pop_front();
+      }
+    }
+  }
+
+  if(!task) return false;
+  --pending;
+  task();
+  return true;
+}
+
+void ThreadPool::helpUntil(const std::function<bool()>& done){
+  while(!done()){
+    if(runOne()) continue;
+    // Nothing left to help with: sleep until a task is queued or one ends
+    std::unique_lock<std::mutex> lock(sleepLock);
+    wake.wait(lock, [this, &done]{ return pending.load() > 0 || done(); });
+  }
+}
+
+void ThreadPool::notifyWaiters(){
+  { std::lock_guard<std::mutex> guard(sleepLock); }
+  wake.notify_all();
+}
+
+void ThreadPool::work(size_t index){
+  Sampler::ignoreOnThisThread();
+  own = queues[index].get();
+  for(;;){
+    if(runOne()) continue;
+    std::unique_lock<std::mutex> lock(sleepLock);
+    wake.wait(lock, [this]{ return stopping || pending.load() > 0; });
+    if(stopping) return;
+  }
+}
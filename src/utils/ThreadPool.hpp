@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Work-stealing pool behind the parallel builtins. Every worker owns a
+   deque: it pushes and pops its own tasks at the back and steals from the
+   front of the others when it runs dry. A thread waiting for its tasks
+   helps instead of blocking, so nested parallel sections cannot deadlock.
+   The pool has one worker per core besides the caller, or TER_THREADS - 1. */
+class ThreadPool {
+  public:
+    using Task = std::function<void()>;
+
+    static ThreadPool& get_instance() {
+      static ThreadPool instance;
+      return instance;
+    }
+
+    // Threads that run tasks: the workers plus the thread waiting on them
+    size_t concurrency() const;
+
+    void submit(Task task);
+
+    // Runs queued tasks on this thread until done() returns true
+    void helpUntil(const std::function<bool()>& done);
+    // Wakes threads in helpUntil after something their done() reads changed
+    void notifyWaiters();
+
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    void operator=(const ThreadPool&) = delete;
+
+  private:
+    struct Queue {
+      std::mutex lock;
+      std::deque<Task> tasks;
+    };
+
+    // One per worker, plus a last one for threads outside the pool
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> pending{0};
+    std::atomic<size_t> nextQueue{0};
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    // Queue of the calling thread when it is a worker
+    inline static thread_local Queue* own = nullptr;
+
+    ThreadPool();
+    bool runOne();
+    void work(size_t index);
+};
@@ -0,0 +1,95 @@
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include "Tracer.hpp"
+
+namespace {
+  int64_t nanos(Tracer::clock::duration duration){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+  }
+
+  // Small sequential ids read better in the viewer than native thread ids
+  uint64_t threadId(){
+    static std::atomic<uint64_t> next{1};
+    thread_local uint64_t id = next++;
+    return id;
+  }
+}
+
+Tracer::Span::Span(const char* category, std::string name) :
+  category{category}, name{std::move(name)} {
+  if(Tracer::get_instance().enabled()){
+    start = clock::now();
+  }
+}
+
+Tracer::Span::~Span(){
+  Tracer& tracer = Tracer::get_instance();
+  if(tracer.enabled()){
+    tracer.complete(category, std::move(name), start, std::move(args));
+  }
+}
+
+void Tracer::start(int64_t thresholdUs){
+  active = true;
+  thresholdNs = thresholdUs * 1000;
+  origin = clock::now();
+}
+
+void Tracer::complete(const char* category, std::string name, clock::time_point start, std::string args){
+  int64_t duration = nanos(clock::now() - start);
+  std::lock_guard<std::mutex> guard(lock);
+  events.push_back({category, std::move(name), nanos(start - origin), duration, threadId(), std::move(args)});
+}
+
+void Tracer::call(const std::string& name, int line, clock::time_point start){
+  if(nanos(clock::now() - start) < thresholdNs) return;
+  complete("call", name, start, line > 0 ? "\"line\":" + std::to_string(line) : "");
+}
+
+std::string Tracer::quote(const std::string& text){
+  std::string result = "\"";
+  for(char c : text){
+    switch(c){
+      case '"': result += "\\\""; break;
+      case '\\': result += "\\\\"; break;
+      case '\n': result += "\\n"; break;
+      case '\r': result += "\\r"; break;
+      case '\t': result += "\\t"; break;
+      default:
+        if(static_cast<unsigned char>(c) < 0x20){
+          char escaped[8];
+          std::snprintf(escaped, sizeof escaped, "\\u%04x", c);
+          result += escaped;
+        }else{
+          result += c;
+        }
+    }
+  }
+  return result + "\"";
+}
+
+void Tracer::write(const std::string& path){
+  std::ofstream out(path);
+  if(!out){
+    std::cerr << "Cannot write trace to '" << path << "'.\n";
+    return;
+  }
+
+  std::lock_guard<std::mutex> guard(lock);
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"ter\"}}";
+  char time[64];
+  for(const Event& event : events){
+    // Trace timestamps are microseconds
+    std::snprintf(time, sizeof time, "\"ts\":%.3f,\"dur\":%.3f",
+        static_cast<double>(event.startNs) / 1e3, static_cast<double>(event.durationNs) / 1e3);
+    out << ",\n{\"name\":" << quote(event.name)
+      << ",\"cat\":\"" << event.category << "\",\"ph\":\"X\","
+      << time << ",\"pid\":1,\"tid\":" << event.thread
+      << ",\"args\":{" << event.args << "}}";
+  }
+  out << "\n]}\n";
+}
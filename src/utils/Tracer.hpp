@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/* Chrome/Perfetto trace events written by `ter --trace=trace.json`. Spans
+   cover the scan, parse and resolve phases, every included file, every
+   exec() child and every call that takes longer than the threshold. When
+   tracing is off a Span only checks a flag. */
+class Tracer {
+  public:
+    using clock = std::chrono::steady_clock;
+
+    class Span {
+      public:
+        Span(const char* category, std::string name);
+        ~Span();
+        // Extra "args" members, already formatted as JSON
+        std::string args;
+
+      private:
+        const char* category;
+        std::string name;
+        clock::time_point start;
+    };
+
+    static Tracer& get_instance() {
+      static Tracer instance;
+      return instance;
+    }
+
+    void start(int64_t thresholdUs);
+    bool enabled() const { return active; }
+
+    void complete(const char* category, std::string name, clock::time_point start, std::string args = "");
+    // Calls are only kept when they ran for longer than the threshold
+    void call(const std::string& name, int line, clock::time_point start);
+    void write(const std::string& path);
+
+    static std::string quote(const std::string& text);
+
+    Tracer(const Tracer&) = delete;
+    void operator=(const Tracer&) = delete;
+
+  private:
+    struct Event {
+      const char* category;
+      std::string name;
+      int64_t startNs;
+      int64_t durationNs;
+      uint64_t thread;
+      std::string args;
+    };
+
+    bool active = false;
+    int64_t thresholdNs = 0;
+    clock::time_point origin;
+    std::mutex lock;
+    std::vector<Event> events;
+
+    Tracer() = default;
+};
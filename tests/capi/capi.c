@@ -0,0 +1,141 @@
+/* Drives libterlang through include/terlang.h: evaluation, calls in both
+   directions, errors, captured output and zero-copy strings and arrays. */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "terlang.h"
+
+static int failures = 0;
+
+#define CHECK(condition) do { \
+    if(!(condition)){ \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+      ++failures; \
+    } \
+  } while(0)
+
+static ter_value* sum(ter_isolate* isolate, ter_value* const* args, size_t count, void* data){
+  size_t length = 0;
+  double* numbers = ter_array_numbers(args[0], &length);
+  double total = 0;
+  size_t i;
+  (void)count;
+  ++*(int*)data;
+  if(numbers == NULL){
+    ter_error(isolate, "sum() expects an array of numbers.");
+    return NULL;
+  }
+  for(i = 0; i < length; ++i){
+    total += numbers[i];
+  }
+  return ter_number(total);
+}
+
+static const char program[] =
+  "set greet(name){ return \"hello \" + name }\n"
+  "set scale(values, count, k){\n"
+  "  auto scaled = {}\n"
+  "  for(auto i = 0; i < count; ++i){ scaled[i] = values[i] * k }\n"
+  "  return scaled\n"
+  "}\n"
+  "set total(values){ return sum(values) }\n"
+  "output(\"loaded\")\n";
+
+int main(void){
+  const char* argv[] = {"ter", "embedded", "first"};
+  ter_isolate* isolate = ter_isolate_new(3, argv, TER_CAPTURE_OUTPUT);
+  int calls = 0;
+  size_t length = 0;
+  const char* text;
+  ter_value* result;
+  ter_value* args[3];
+  double* numbers;
+  char* chars;
+  int i;
+
+  CHECK(ter_register(isolate, "sum", 1, sum, &calls) == 0);
+  CHECK(ter_eval(isolate, program, strlen(program), "program.ter") == 0);
+  text = ter_output(isolate, &length);
+  CHECK(length == 7 && strcmp(text, "loaded\n") == 0);
+  ter_output_clear(isolate);
+
+  /* Strings in and out */
+  args[0] = ter_string_new(3, &chars);
+  memcpy(chars, "ter", 3);
+  result = ter_call(isolate, "greet", args, 1);
+  CHECK(result != NULL && ter_typeof(result) == TER_STRING);
+  text = ter_string_data(result, &length);
+  CHECK(text != NULL && length == 9 && memcmp(text, "hello ter", 9) == 0);
+  ter_value_free(result);
+  ter_value_free(args[0]);
+
+  /* Numeric arrays in and out: the result of scale() is read in place */
+  args[0] = ter_array_new(4, &numbers);
+  for(i = 0; i < 4; ++i) numbers[i] = i + 1;
+  args[1] = ter_number(4);
+  args[2] = ter_number(10);
+  result = ter_call(isolate, "scale", args, 3);
+  CHECK(result != NULL && ter_typeof(result) == TER_ARRAY && ter_array_length(result) == 4);
+  numbers = ter_array_numbers(result, &length);
+  CHECK(numbers != NULL && length == 4 && numbers[0] == 10 && numbers[3] == 40);
+  ter_value_free(result);
+  ter_value_free(args[1]);
+  ter_value_free(args[2]);
+
+  /* Ter calling back into C */
+  result = ter_call(isolate, "total", args, 1);
+  CHECK(result != NULL && ter_to_number(result) == 10 && calls == 1);
+  ter_value_free(result);
+  ter_value_free(args[0]);
+
+  /* Errors raised by a native function and by Ter */
+  args[0] = ter_string("x", 1);
+  CHECK(ter_call(isolate, "total", args, 1) == NULL);
+  CHECK(strstr(ter_last_error(isolate), "sum() expects an array of numbers.") != NULL);
+  ter_value_free(args[0]);
+  CHECK(ter_call(isolate, "missing", NULL, 0) == NULL);
+  CHECK(strstr(ter_last_error(isolate), "missing") != NULL);
+  CHECK(ter_eval(isolate, "auto x = ", 9, "bad.ter") == 65);
+  CHECK(strstr(ter_last_error(isolate), "Expected expression") != NULL);
+
+  /* Allocation failures come back as NULL, not as C++ exceptions */
+  CHECK(ter_string_new((size_t)-1, &chars) == NULL && chars == NULL);
+  CHECK(ter_array_new((size_t)-1 / 2, &numbers) == NULL && numbers == NULL);
+
+  /* Frozen arrays are only handed out read-only */
+  CHECK(ter_eval(isolate, "auto table = freeze({1, 2})", 27, NULL) == 0);
+  result = ter_get_global(isolate, "table");
+  CHECK(result != NULL && ter_array_numbers(result, &length) == NULL);
+  {
+    const double* view = ter_array_view(result, &length);
+    CHECK(view != NULL && length == 2 && view[1] == 2);
+  }
+  ter_value_free(result);
+
+  /* Globals survive between evaluations; a second isolate does not see them */
+  CHECK(ter_eval(isolate, "auto answer = 42", 16, NULL) == 0);
+  result = ter_get_global(isolate, "answer");
+  CHECK(result != NULL && ter_to_number(result) == 42);
+  ter_value_free(result);
+  CHECK(ter_eval(isolate, "auto seen = stats().calls", 25, NULL) == 0);
+  {
+    ter_isolate* other = ter_isolate_new(0, NULL, TER_CAPTURE_OUTPUT);
+    CHECK(ter_get_global(other, "answer") == NULL);
+    CHECK(ter_eval(other, "output(args())", 14, NULL) == 0);
+    ter_isolate_free(other);
+  }
+  CHECK(ter_eval(isolate, "output(args())", 14, NULL) == 0);
+  text = ter_output(isolate, &length);
+  CHECK(strcmp(text, "[first]\n") == 0);
+
+  /* ...nor reset its counters */
+  CHECK(ter_eval(isolate, "auto lost = seen - stats().calls", 32, NULL) == 0);
+  result = ter_get_global(isolate, "lost");
+  CHECK(result != NULL && ter_to_number(result) < 0);
+  ter_value_free(result);
+
+  ter_isolate_free(isolate);
+  if(failures == 0) printf("capi: all checks passed\n");
+  return failures == 0 ? 0 : 1;
+}